@@ -0,0 +1,16 @@
+#!/usr/bin/env sh
+# Solver time per timestep of the generated RC networks as N grows.
+# Usage: ./benchmark.sh <path to ams-eln3 binary>
+BIN=${1:-./ams-eln3}
+
+for n in 10 100 1000 10000
+do
+    $BIN ladder $n
+    $BIN ladder $n switch
+done
+
+for n in 4 16 32 64 100
+do
+    $BIN mesh $n
+    $BIN mesh $n switch
+done
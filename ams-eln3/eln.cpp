@@ -0,0 +1,93 @@
+#include <systemc.h>
+#include <systemc-ams.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "rc_network.h"
+
+// Toggles the bypass switch of the network, which changes the matrix of the
+// equation system. Without the switch only the source value changes from
+// timestep to timestep.
+SC_MODULE(switch_driver)
+{
+    sc_out<bool> ctrl;
+    sc_time period;
+
+    SC_HAS_PROCESS(switch_driver);
+    switch_driver(sc_module_name nm, sc_time period) : ctrl("ctrl"),
+                                                        period(period)
+    {
+        SC_THREAD(process);
+    }
+
+    void process()
+    {
+        bool value = false;
+        while(true)
+        {
+            ctrl.write(value);
+            wait(period);
+            value = !value;
+        }
+    }
+};
+
+int sc_main(int argc, char* argv[])
+{
+    // Usage: ams-eln3 [ladder|mesh] [N] [switch]
+    //   ladder N: RC ladder with N stages
+    //   mesh N:   RC mesh with N x N nodes
+    //   switch:   toggle a switch every 1 ms, i.e. the matrix changes
+    bool mesh = argc > 1 && strcmp(argv[1], "mesh") == 0;
+    unsigned int n = argc > 2 ? atoi(argv[2]) : 100;
+    bool withSwitch = argc > 3 && strcmp(argv[3], "switch") == 0;
+
+    sca_core::sca_time timestep(10, sc_core::SC_US);
+    sc_core::sc_time simulationTime(100, sc_core::SC_MS);
+
+    rc_network *network;
+    if(mesh)
+    {
+        network = new rc_mesh("rc_mesh", n, n, timestep, withSwitch);
+    }
+    else
+    {
+        network = new rc_ladder("rc_ladder", n, timestep, withSwitch);
+    }
+
+    sc_signal<bool> ctrl("ctrl");
+    network->ctrl(ctrl);
+
+    switch_driver *driver = nullptr;
+    if(withSwitch)
+    {
+        driver = new switch_driver("driver", sc_time(1, SC_MS));
+        driver->ctrl(ctrl);
+    }
+
+    // The first call includes elaboration, the setup of the equation
+    // system and the first factorization of the matrix:
+    auto start = std::chrono::steady_clock::now();
+    sc_core::sc_start(timestep);
+    auto setup = std::chrono::steady_clock::now();
+    sc_core::sc_start(simulationTime - timestep);
+    auto end = std::chrono::steady_clock::now();
+
+    double steps = simulationTime / timestep - 1;
+    double setupTime = std::chrono::duration<double, std::milli>(
+                           setup - start).count();
+    double stepTime = std::chrono::duration<double, std::micro>(
+                          end - setup).count() / steps;
+
+    std::cout << (mesh ? "mesh" : "ladder")
+              << " N=" << n
+              << " nodes=" << network->size()
+              << (withSwitch ? " switch" : "")
+              << " setup=" << setupTime << "ms"
+              << " timestep=" << stepTime << "us" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,175 @@
+#ifndef RC_NETWORK_H
+#define RC_NETWORK_H
+
+#include <systemc.h>
+#include <systemc-ams.h>
+
+#include <string>
+#include <vector>
+
+// Netlist generators that scale the RC circuit of ams-eln to large
+// networks. All primitives are created during elaboration, therefore the
+// size of the network is a runtime parameter.
+//
+// If withSwitch is set, a DE controlled switch is placed in parallel to the
+// resistor next to the source. Every toggle of the switch changes the
+// equation system of the ELN cluster and forces the solver to factorize the
+// matrix again, whereas a changing source value only changes the right hand
+// side and the existing factorization is reused.
+
+SC_MODULE(rc_network)
+{
+    sca_eln::sca_node_ref gnd;
+    sca_eln::sca_vsource vin;
+    sc_core::sc_in<bool> ctrl;
+
+    std::vector<sca_eln::sca_node*> nodes;
+    std::vector<sca_eln::sca_r*> resistors;
+    std::vector<sca_eln::sca_c*> capacitors;
+    sca_eln::sca_de::sca_rswitch *sw;
+
+    rc_network(sc_core::sc_module_name nm, sca_core::sca_time timestep) :
+        vin("vin",      // Name
+            0.0,        // Init
+            0.0,        // Offset
+            1.0,        // Amplitude
+            1000.0),    // Frequency
+        ctrl("ctrl"),
+        sw(nullptr)
+    {
+        vin.set_timestep(timestep);
+        vin.n(gnd);
+    }
+
+    unsigned int size() const
+    {
+        return nodes.size();
+    }
+
+    protected:
+    sca_eln::sca_node* node()
+    {
+        std::string n = "n" + std::to_string(nodes.size());
+        nodes.push_back(new sca_eln::sca_node(n.c_str()));
+        return nodes.back();
+    }
+
+    void resistor(sca_eln::sca_node &p, sca_eln::sca_node &n, double value)
+    {
+        std::string name = "r" + std::to_string(resistors.size());
+        sca_eln::sca_r *r = new sca_eln::sca_r(name.c_str(), value);
+        r->p(p);
+        r->n(n);
+        resistors.push_back(r);
+    }
+
+    void capacitor(sca_eln::sca_node &p, double value)
+    {
+        std::string name = "c" + std::to_string(capacitors.size());
+        sca_eln::sca_c *c = new sca_eln::sca_c(name.c_str(), value);
+        c->p(p);
+        c->n(gnd);
+        capacitors.push_back(c);
+    }
+
+    void bypass(sca_eln::sca_node &p, sca_eln::sca_node &n)
+    {
+        sw = new sca_eln::sca_de::sca_rswitch("sw", 1.0e-3, 1.0e9);
+        sw->p(p);
+        sw->n(n);
+        sw->ctrl(ctrl);
+    }
+};
+
+// N stage RC ladder:
+//
+//   n0 +  n1 +   n2 +       nN +
+//    +-[R]-+-[R]-+-- ... -[R]-+
+//   +|     |     |            |
+//   Vin   [C]   [C]          [C]
+//   -|     |     |            |
+//   -+-   -+-   -+-          -+- GND
+//
+class rc_ladder : public rc_network
+{
+    public:
+    rc_ladder(sc_core::sc_module_name nm,
+              unsigned int stages,
+              sca_core::sca_time timestep,
+              bool withSwitch = false,
+              double r = 1000.0,
+              double c = 1.0e-9) : rc_network(nm, timestep)
+    {
+        sca_eln::sca_node *previous = node();
+        vin.p(*previous);
+
+        for(unsigned int i = 0; i < stages; i++)
+        {
+            sca_eln::sca_node *next = node();
+            resistor(*previous, *next, r);
+            capacitor(*next, c);
+
+            if(withSwitch && i == 0)
+            {
+                bypass(*previous, *next);
+            }
+            previous = next;
+        }
+    }
+};
+
+// Rows x columns RC mesh, e.g. a simple power grid. Every grid node has a
+// capacitor to ground, neighbours are connected by resistors and the source
+// feeds the corner node (0,0) through a resistor.
+class rc_mesh : public rc_network
+{
+    public:
+    rc_mesh(sc_core::sc_module_name nm,
+            unsigned int rows,
+            unsigned int columns,
+            sca_core::sca_time timestep,
+            bool withSwitch = false,
+            double r = 1000.0,
+            double c = 1.0e-9) : rc_network(nm, timestep)
+    {
+        if(rows == 0 || columns == 0)
+        {
+            SC_REPORT_ERROR(name(), "The mesh needs at least one row and "
+                                    "one column");
+            return;
+        }
+
+        sca_eln::sca_node *supply = node();
+        vin.p(*supply);
+
+        std::vector<sca_eln::sca_node*> grid;
+
+        for(unsigned int y = 0; y < rows; y++)
+        {
+            for(unsigned int x = 0; x < columns; x++)
+            {
+                sca_eln::sca_node *n = node();
+                capacitor(*n, c);
+
+                if(x > 0)
+                {
+                    resistor(*grid[y * columns + x - 1], *n, r);
+                }
+                if(y > 0)
+                {
+                    resistor(*grid[(y - 1) * columns + x], *n, r);
+                }
+                grid.push_back(n);
+            }
+        }
+
+        resistor(*supply, *grid[0], r);
+
+        if(withSwitch)
+        {
+            bypass(*supply, *grid[0]);
+        }
+    }
+};
+
+#endif // RC_NETWORK_H
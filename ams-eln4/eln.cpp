@@ -0,0 +1,42 @@
+#include<systemc.h>
+#include<systemc-ams.h>
+
+#include <iostream>
+
+#include "netlist.h"
+#include "spice_circuit.h"
+
+int sc_main(int argc, char* argv[])
+{
+    // Usage: ams-eln4 <netlist> [simulation time in s] [timestep in s]
+    const char *file = argc > 1 ? argv[1] : "rc.cir";
+    double simulationTime = argc > 2 ? atof(argv[2]) : 3.5;
+    double timestep = argc > 3 ? atof(argv[3]) : 0.1;
+
+    netlist n;
+    try
+    {
+        n = netlist::load(file);
+    }
+    catch(const std::exception &e)
+    {
+        SC_REPORT_FATAL("netlist", e.what());
+    }
+
+    std::cout << file << ": " << n.nodes.size() - 1 << " nodes, "
+              << n.elements.size() << " elements" << std::endl;
+
+    spice_circuit cir("spice_circuit", n,
+                      sca_core::sca_time(timestep, sc_core::SC_SEC));
+
+    // Trace all node voltages:
+    sca_util::sca_trace_file* tf = sca_util::sca_create_tabular_trace_file("trace.dat");
+    for(unsigned int i = 1; i < cir.nodes.size(); i++)
+    {
+        sca_util::sca_trace(tf, *cir.nodes[i], n.nodes[i]);
+    }
+    sc_core::sc_start(simulationTime, sc_core::SC_SEC);
+    sca_util::sca_close_tabular_trace_file(tf);
+
+    return 0;
+}
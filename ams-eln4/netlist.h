@@ -0,0 +1,419 @@
+#ifndef NETLIST_H
+#define NETLIST_H
+
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Parsed form of a small SPICE subset:
+//
+//   * comment
+//   R<name> <node+> <node-> <value>
+//   C<name> <node+> <node-> <value>
+//   L<name> <node+> <node-> <value>
+//   V<name> <node+> <node-> [DC] <value>
+//   V<name> <node+> <node-> SIN(<offset> <amplitude> <frequency> [<delay>])
+//   V<name> <node+> <node-> PULSE(<v1> <v2> [<delay> [<rise> [<fall>
+//                                 [<width> [<period>]]]]])
+//   I<name> ... (same as V)
+//   .end
+//
+// Values may carry the usual SPICE scale suffixes (f, p, n, u, m, k, meg,
+// g, t). Node 0 or gnd is the reference node. As in SPICE, a SIN source
+// holds its offset and a PULSE source v1 until the delay has passed. A
+// PULSE without width or period stays at v2, a rise or fall time of 0 is a
+// step.
+struct netlist
+{
+    enum type : uint8_t
+    {
+        resistor,
+        capacitor,
+        inductor,
+        vsource,
+        isource
+    };
+
+    enum waveform : uint8_t
+    {
+        dc,
+        sine,
+        pulse
+    };
+
+    struct element
+    {
+        type kind;
+        waveform shape;   // Sources only
+        std::string name;
+        uint32_t p;
+        uint32_t n;
+        double value;     // R, C, L, DC value, SIN offset or PULSE v1
+        double amplitude; // SIN amplitude or PULSE v2
+        double frequency; // SIN only
+        double delay;     // Until then the source holds value
+        double rise;      // PULSE only
+        double fall;      // PULSE only
+        double width;     // PULSE only
+        double period;    // PULSE only
+    };
+
+    // nodes[0] is always the reference node:
+    std::vector<std::string> nodes;
+    std::vector<element> elements;
+
+    netlist() : nodes(1, "0")
+    {
+    }
+
+    // Uses the binary cache <file>.bin if it was written for the current
+    // contents of the netlist, otherwise the netlist is parsed and the cache
+    // is rewritten. Hashing the text is much cheaper than parsing it, and
+    // unlike the modification time it also catches edits within a second.
+    static netlist load(const std::string &file)
+    {
+        netlist result;
+        std::string cache = file + ".bin";
+        uint64_t stamp = hash(file);
+
+        if(result.readCache(cache, stamp))
+        {
+            return result;
+        }
+
+        result = netlist();
+        result.parse(file);
+        result.writeCache(cache, stamp);
+        return result;
+    }
+
+    void parse(const std::string &file)
+    {
+        std::ifstream in(file);
+        if(!in)
+        {
+            throw std::runtime_error("Cannot open netlist " + file);
+        }
+
+        std::string line;
+        unsigned int lineNumber = 0;
+        while(std::getline(in, line))
+        {
+            lineNumber++;
+            for(char &c : line)
+            {
+                c = std::tolower(c);
+            }
+
+            // Sources may be written as sin(offset amplitude frequency) or
+            // pulse(v1 v2 ...):
+            for(char &c : line)
+            {
+                if(c == '(' || c == ')' || c == ',')
+                {
+                    c = ' ';
+                }
+            }
+
+            std::istringstream tokens(line);
+            std::vector<std::string> t;
+            std::string token;
+            while(tokens >> token)
+            {
+                t.push_back(token);
+            }
+
+            if(t.empty() || t[0][0] == '*')
+            {
+                continue;
+            }
+            if(t[0] == ".end")
+            {
+                break;
+            }
+            if(t.size() < 4)
+            {
+                throw std::runtime_error(error(file, lineNumber,
+                                               "Incomplete element"));
+            }
+
+            element e;
+            e.name = t[0];
+            e.p = node(t[1]);
+            e.n = node(t[2]);
+            e.shape = dc;
+            e.value = 0.0;
+            e.amplitude = 0.0;
+            e.frequency = 0.0;
+            e.delay = 0.0;
+            e.rise = 0.0;
+            e.fall = 0.0;
+            e.width = std::numeric_limits<double>::infinity();
+            e.period = std::numeric_limits<double>::infinity();
+
+            switch(t[0][0])
+            {
+                case 'r': e.kind = resistor;  break;
+                case 'c': e.kind = capacitor; break;
+                case 'l': e.kind = inductor;  break;
+                case 'v': e.kind = vsource;   break;
+                case 'i': e.kind = isource;   break;
+                default:
+                    throw std::runtime_error(error(file, lineNumber,
+                                                   "Unknown element " + t[0]));
+            }
+
+            if(e.kind == vsource || e.kind == isource)
+            {
+                if(t[3] == "sin" && (t.size() == 7 || t.size() == 8))
+                {
+                    e.shape = sine;
+                    e.value = number(t[4], file, lineNumber);
+                    e.amplitude = number(t[5], file, lineNumber);
+                    e.frequency = number(t[6], file, lineNumber);
+                    if(t.size() == 8)
+                    {
+                        e.delay = number(t[7], file, lineNumber);
+                    }
+                }
+                else if(t[3] == "pulse" && t.size() >= 6 && t.size() <= 11)
+                {
+                    e.shape = pulse;
+                    e.value = number(t[4], file, lineNumber);
+                    e.amplitude = number(t[5], file, lineNumber);
+                    double *optional[] = {&e.delay, &e.rise, &e.fall,
+                                          &e.width, &e.period};
+                    for(unsigned int i = 6; i < t.size(); i++)
+                    {
+                        *optional[i - 6] = number(t[i], file, lineNumber);
+                    }
+                }
+                else if(t[3] == "dc" && t.size() == 5)
+                {
+                    e.value = number(t[4], file, lineNumber);
+                }
+                else if(t.size() == 4)
+                {
+                    e.value = number(t[3], file, lineNumber);
+                }
+                else
+                {
+                    throw std::runtime_error(error(file, lineNumber,
+                                                   "Unsupported source"));
+                }
+            }
+            else
+            {
+                e.value = number(t[3], file, lineNumber);
+            }
+
+            elements.push_back(e);
+        }
+    }
+
+    private:
+    static constexpr uint32_t magic = 0x4e435053; // "SPCN"
+    static constexpr uint32_t version = 3;
+
+    uint32_t node(const std::string &name)
+    {
+        if(name == "0" || name == "gnd")
+        {
+            return 0;
+        }
+        for(uint32_t i = 1; i < nodes.size(); i++)
+        {
+            if(nodes[i] == name)
+            {
+                return i;
+            }
+        }
+        nodes.push_back(name);
+        return nodes.size() - 1;
+    }
+
+    static double number(const std::string &s,
+                         const std::string &file,
+                         unsigned int line)
+    {
+        char *end;
+        double value = std::strtod(s.c_str(), &end);
+        std::string suffix(end);
+
+        if(end == s.c_str())
+        {
+            throw std::runtime_error(error(file, line, "Invalid number " + s));
+        }
+
+        if(suffix.compare(0, 3, "meg") == 0) return value * 1e6;
+        switch(suffix.empty() ? ' ' : suffix[0])
+        {
+            case 'f': return value * 1e-15;
+            case 'p': return value * 1e-12;
+            case 'n': return value * 1e-9;
+            case 'u': return value * 1e-6;
+            case 'm': return value * 1e-3;
+            case 'k': return value * 1e3;
+            case 'g': return value * 1e9;
+            case 't': return value * 1e12;
+            default:  return value; // e.g. units like 5v or 10ohm
+        }
+    }
+
+    static std::string error(const std::string &file,
+                             unsigned int line,
+                             const std::string &message)
+    {
+        return file + ":" + std::to_string(line) + ": " + message;
+    }
+
+    // FNV-1a hash of the netlist text:
+    static uint64_t hash(const std::string &file)
+    {
+        std::ifstream in(file, std::ios::binary);
+        if(!in)
+        {
+            throw std::runtime_error("Cannot open netlist " + file);
+        }
+
+        uint64_t h = 0xcbf29ce484222325ull;
+        char buffer[4096];
+        while(in.read(buffer, sizeof(buffer)) || in.gcount() > 0)
+        {
+            for(std::streamsize i = 0; i < in.gcount(); i++)
+            {
+                h = (h ^ uint8_t(buffer[i])) * 0x100000001b3ull;
+            }
+        }
+        return h;
+    }
+
+    // Binary cache layout (host byte order):
+    //   u32 magic, u32 version, u64 hash of the netlist
+    //   u32 #nodes,    then per node:    u32 length, name
+    //   u32 #elements, then per element: u8 type, u8 waveform, u32 length,
+    //                                    name, u32 p, u32 n, 8 x double
+    template <class T>
+    static void put(std::ofstream &out, const T &value)
+    {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    static void put(std::ofstream &out, const std::string &value)
+    {
+        put(out, uint32_t(value.size()));
+        out.write(value.data(), value.size());
+    }
+
+    template <class T>
+    static bool get(std::ifstream &in, T &value)
+    {
+        return bool(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+    }
+
+    static bool get(std::ifstream &in, std::string &value)
+    {
+        uint32_t size;
+        if(!get(in, size) || size > (1u << 20))
+        {
+            return false;
+        }
+        value.resize(size);
+        return bool(in.read(&value[0], size));
+    }
+
+    void writeCache(const std::string &file, uint64_t stamp) const
+    {
+        std::ofstream out(file, std::ios::binary);
+        if(!out)
+        {
+            return; // The cache is optional
+        }
+
+        put(out, uint32_t(magic));
+        put(out, uint32_t(version));
+        put(out, stamp);
+
+        put(out, uint32_t(nodes.size()));
+        for(const std::string &n : nodes)
+        {
+            put(out, n);
+        }
+
+        put(out, uint32_t(elements.size()));
+        for(const element &e : elements)
+        {
+            put(out, uint8_t(e.kind));
+            put(out, uint8_t(e.shape));
+            put(out, e.name);
+            put(out, e.p);
+            put(out, e.n);
+            put(out, e.value);
+            put(out, e.amplitude);
+            put(out, e.frequency);
+            put(out, e.delay);
+            put(out, e.rise);
+            put(out, e.fall);
+            put(out, e.width);
+            put(out, e.period);
+        }
+    }
+
+    bool readCache(const std::string &file, uint64_t stamp)
+    {
+        std::ifstream in(file, std::ios::binary);
+        uint32_t m, v, count;
+        uint64_t s;
+
+        if(!in || !get(in, m) || !get(in, v) || !get(in, s)
+           || m != magic || v != version || s != stamp)
+        {
+            return false;
+        }
+
+        if(!get(in, count) || count == 0 || count > (1u << 24))
+        {
+            return false;
+        }
+        nodes.resize(count);
+        for(std::string &n : nodes)
+        {
+            if(!get(in, n))
+            {
+                return false;
+            }
+        }
+
+        if(!get(in, count) || count > (1u << 24))
+        {
+            return false;
+        }
+        elements.resize(count);
+        for(element &e : elements)
+        {
+            uint8_t kind, shape;
+            if(!get(in, kind) || !get(in, shape) || !get(in, e.name)
+               || !get(in, e.p) || !get(in, e.n)
+               || !get(in, e.value) || !get(in, e.amplitude)
+               || !get(in, e.frequency) || !get(in, e.delay)
+               || !get(in, e.rise) || !get(in, e.fall)
+               || !get(in, e.width) || !get(in, e.period)
+               || kind > isource || shape > pulse
+               || e.p >= nodes.size() || e.n >= nodes.size())
+            {
+                return false;
+            }
+            e.kind = type(kind);
+            e.shape = waveform(shape);
+        }
+        return true;
+    }
+};
+
+#endif // NETLIST_H
@@ -0,0 +1,162 @@
+#ifndef SPICE_CIRCUIT_H
+#define SPICE_CIRCUIT_H
+
+#include <systemc.h>
+#include <systemc-ams.h>
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "netlist.h"
+
+// PULSE waveform of a source, sampled at the timestep of the cluster:
+SCA_TDF_MODULE(pulse_source)
+{
+    public:
+    sca_tdf::sca_out<double> out;
+
+    pulse_source(sc_core::sc_module_name nm, const netlist::element &e)
+        : out("out"), e(e)
+    {
+    }
+
+    void processing()
+    {
+        out.write(value(get_time().to_seconds()));
+    }
+
+    private:
+    netlist::element e;
+
+    double value(double t) const
+    {
+        if(t < e.delay)
+        {
+            return e.value;
+        }
+
+        // An infinite period leaves t unchanged:
+        t = std::fmod(t - e.delay, e.period);
+        if(t < e.rise)
+        {
+            return e.value + (e.amplitude - e.value) * t / e.rise;
+        }
+        t -= e.rise;
+        if(t < e.width)
+        {
+            return e.amplitude;
+        }
+        t -= e.width;
+        if(t < e.fall)
+        {
+            return e.amplitude + (e.value - e.amplitude) * t / e.fall;
+        }
+        return e.value;
+    }
+};
+
+// Elaborates the sca_eln primitives of a netlist at runtime, i.e. the same
+// circuit as the hand-written eln_circuit of ams-eln can be simulated from
+// a netlist file without recompiling.
+SC_MODULE(spice_circuit)
+{
+    sca_eln::sca_node_ref gnd;
+    std::vector<sca_eln::sca_node*> nodes;
+
+    spice_circuit(sc_core::sc_module_name nm,
+                  const netlist &n,
+                  sca_core::sca_time timestep) : nodes(n.nodes.size(), nullptr)
+    {
+        for(unsigned int i = 1; i < n.nodes.size(); i++)
+        {
+            nodes[i] = new sca_eln::sca_node(n.nodes[i].c_str());
+        }
+
+        if(n.elements.empty())
+        {
+            SC_REPORT_FATAL(name(), "Netlist contains no elements");
+        }
+
+        for(const netlist::element &e : n.elements)
+        {
+            const char *element = e.name.c_str();
+            sca_eln::sca_module *m = nullptr;
+            // As in SPICE, SIN sources hold their offset until the delay:
+            sca_core::sca_time delay(e.delay, sc_core::SC_SEC);
+
+            switch(e.kind)
+            {
+                case netlist::resistor:
+                    m = bind(new sca_eln::sca_r(element, e.value), e);
+                    break;
+                case netlist::capacitor:
+                    m = bind(new sca_eln::sca_c(element, e.value), e);
+                    break;
+                case netlist::inductor:
+                    m = bind(new sca_eln::sca_l(element, e.value), e);
+                    break;
+                case netlist::vsource:
+                    if(e.shape == netlist::pulse)
+                    {
+                        auto *v = new sca_eln::sca_tdf::sca_vsource(element);
+                        v->inp(pulse(e));
+                        m = bind(v, e);
+                    }
+                    else
+                    {
+                        m = bind(new sca_eln::sca_vsource(element, e.value,
+                                                          e.value,
+                                                          e.amplitude,
+                                                          e.frequency, 0.0,
+                                                          delay), e);
+                    }
+                    break;
+                case netlist::isource:
+                    if(e.shape == netlist::pulse)
+                    {
+                        auto *i = new sca_eln::sca_tdf::sca_isource(element);
+                        i->inp(pulse(e));
+                        m = bind(i, e);
+                    }
+                    else
+                    {
+                        m = bind(new sca_eln::sca_isource(element, e.value,
+                                                          e.value,
+                                                          e.amplitude,
+                                                          e.frequency, 0.0,
+                                                          delay), e);
+                    }
+                    break;
+            }
+
+            // One timestep in the cluster is sufficient:
+            if(&e == &n.elements.front())
+            {
+                m->set_timestep(timestep);
+            }
+        }
+    }
+
+    private:
+    // PULSE sources are converter sources driven by a pulse_source:
+    sca_tdf::sca_signal<double>& pulse(const netlist::element &e)
+    {
+        std::string source = e.name + "_pulse";
+        auto *signal =
+            new sca_tdf::sca_signal<double>((source + "_signal").c_str());
+        auto *generator = new pulse_source(source.c_str(), e);
+        generator->out(*signal);
+        return *signal;
+    }
+
+    template <class T>
+    T* bind(T *primitive, const netlist::element &e)
+    {
+        if(e.p == 0) primitive->p(gnd); else primitive->p(*nodes[e.p]);
+        if(e.n == 0) primitive->n(gnd); else primitive->n(*nodes[e.n]);
+        return primitive;
+    }
+};
+
+#endif // SPICE_CIRCUIT_H
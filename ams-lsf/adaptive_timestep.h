@@ -0,0 +1,186 @@
+#ifndef ADAPTIVE_TIMESTEP_H
+#define ADAPTIVE_TIMESTEP_H
+
+#include <systemc.h>
+#include <systemc-ams.h>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+// Source for an LSF system with adaptive timestep (dynamic TDF):
+//
+// The module drives the LSF input through a sca_lsf::sca_tdf::sca_source
+// converter and observes the LSF output through a sca_lsf::sca_tdf::sca_sink
+// converter. After every activation it estimates the local error as the
+// difference between the last output sample and its linear extrapolation
+// from the two samples before. If the error exceeds the tolerance the
+// timestep is halved, if it is far below the tolerance the timestep is
+// doubled, bounded by minStep and maxStep. Known discontinuities of the
+// waveform (e.g. the step of a sca_lsf::sca_source) are hit exactly and the
+// timestep restarts with minStep after them.
+SCA_TDF_MODULE(adaptive_source)
+{
+    sca_tdf::sca_out<double> out;
+    sca_tdf::sca_in<double> feedback;
+
+    unsigned long steps;
+
+    adaptive_source(sc_core::sc_module_name nm,
+                    std::function<double(double)> waveform,
+                    std::vector<sca_core::sca_time> discontinuities,
+                    sca_core::sca_time minStep,
+                    sca_core::sca_time maxStep,
+                    double tolerance) :
+        out("out"),
+        feedback("feedback"),
+        steps(0),
+        waveform(waveform),
+        discontinuities(discontinuities),
+        minStep(minStep),
+        maxStep(maxStep),
+        tolerance(tolerance),
+        samples(0)
+    {
+    }
+
+    void set_attributes()
+    {
+        does_attribute_changes();
+        accept_attribute_changes();
+        set_timestep(minStep);
+
+        // The feedback sample belongs to the previous activation:
+        feedback.set_delay(1);
+    }
+
+    void processing()
+    {
+        double now = get_time().to_seconds();
+
+        // Shift the history of (time, output) pairs:
+        for(int i = 2; i > 0; i--)
+        {
+            t[i] = t[i-1];
+            y[i] = y[i-1];
+        }
+        t[0] = last;
+        y[0] = feedback.read();
+        last = now;
+
+        samples++;
+        steps++;
+
+        out.write(waveform(now));
+    }
+
+    void change_attributes()
+    {
+        sca_core::sca_time now = get_time();
+        sca_core::sca_time step = get_timestep();
+
+        // The estimate needs three valid output samples, the very first
+        // feedback sample is only the initial value of the delay:
+        if(samples > 3)
+        {
+            double predicted = y[1] + (y[1] - y[2]) * (t[0] - t[1])
+                                                    / (t[1] - t[2]);
+            double error = std::fabs(y[0] - predicted);
+
+            if(error > tolerance)
+            {
+                step = std::max(step / 2, minStep);
+            }
+            else if(error < tolerance / 8)
+            {
+                step = std::min(step * 2, maxStep);
+            }
+        }
+
+        for(const sca_core::sca_time &d : discontinuities)
+        {
+            if(now == d)
+            {
+                step = minStep;
+                samples = 0;
+            }
+            else if(now < d && now + step > d)
+            {
+                step = d - now;
+            }
+        }
+
+        set_timestep(step);
+    }
+
+    private:
+    std::function<double(double)> waveform;
+    std::vector<sca_core::sca_time> discontinuities;
+    sca_core::sca_time minStep;
+    sca_core::sca_time maxStep;
+    double tolerance;
+
+    unsigned long samples;
+    double last = 0.0;
+    double t[3] = {0.0, 0.0, 0.0};
+    double y[3] = {0.0, 0.0, 0.0};
+};
+
+// Records (time, value) pairs of a TDF signal for comparing runs with
+// different timesteps.
+SCA_TDF_MODULE(sample_recorder)
+{
+    sca_tdf::sca_in<double> in;
+
+    std::vector<double> time;
+    std::vector<double> value;
+
+    SCA_CTOR(sample_recorder) : in("in")
+    {
+    }
+
+    void set_attributes()
+    {
+        accept_attribute_changes();
+    }
+
+    void processing()
+    {
+        time.push_back(get_time().to_seconds());
+        value.push_back(in.read());
+    }
+
+    // Maximal deviation of the samples of this recorder from the reference,
+    // which is linearly interpolated between its sample points:
+    double max_deviation(const sample_recorder &reference) const
+    {
+        double deviation = 0.0;
+        unsigned int j = 0;
+
+        for(unsigned int i = 0; i < time.size(); i++)
+        {
+            while(j + 2 < reference.time.size()
+                  && reference.time[j+1] < time[i])
+            {
+                j++;
+            }
+            if(j + 1 >= reference.time.size()
+               || time[i] > reference.time.back())
+            {
+                break;
+            }
+
+            double t0 = reference.time[j];
+            double t1 = reference.time[j+1];
+            double v0 = reference.value[j];
+            double v1 = reference.value[j+1];
+            double expected = v0 + (v1 - v0) * (time[i] - t0) / (t1 - t0);
+
+            deviation = std::max(deviation, std::fabs(value[i] - expected));
+        }
+        return deviation;
+    }
+};
+
+#endif // ADAPTIVE_TIMESTEP_H
@@ -1,6 +1,11 @@
 #include<systemc.h>
 #include<systemc-ams.h>
 
+#include <cmath>
+#include <cstring>
+
+#include "adaptive_timestep.h"
+
 SC_MODULE(lsf_model)
 { 
     sca_lsf::sca_in in;
@@ -34,12 +39,65 @@ int sc_main(int argc, char* argv[])
     model.in(in);
     model.out(out);
 
+    // Usage: ams-lsf adaptive
+    // Simulates the same model a second time with an adaptive timestep and
+    // compares it against the fixed timestep of 100us above.
+    bool adaptive = argc > 1 && strcmp(argv[1], "adaptive") == 0;
+    sample_recorder *reference = nullptr;
+    sample_recorder *recorder = nullptr;
+    adaptive_source *asrc = nullptr;
+
+    if(adaptive)
+    {
+        sca_tdf::sca_signal<double> *refOut = new sca_tdf::sca_signal<double>("ref_out");
+        sca_lsf::sca_tdf::sca_sink *refSink = new sca_lsf::sca_tdf::sca_sink("ref_sink");
+        refSink->x(out);
+        refSink->outp(*refOut);
+        reference = new sample_recorder("reference");
+        reference->in(*refOut);
+
+        sca_lsf::sca_signal *aIn = new sca_lsf::sca_signal("a_in");
+        sca_lsf::sca_signal *aOut = new sca_lsf::sca_signal("a_out");
+        sca_tdf::sca_signal<double> *srcOut = new sca_tdf::sca_signal<double>("src_out");
+        sca_tdf::sca_signal<double> *sinkOut = new sca_tdf::sca_signal<double>("sink_out");
+
+        asrc = new adaptive_source("asrc",
+            [](double t) { return 10.0 * std::sin(2.0 * M_PI * 10.0 * t); },
+            {},                                  // No discontinuities
+            sca_core::sca_time(10, sc_core::SC_US),  // Minimal timestep
+            sca_core::sca_time(5, sc_core::SC_MS),   // Maximal timestep
+            0.01);                               // Tolerance
+        sca_lsf::sca_tdf::sca_source *conv = new sca_lsf::sca_tdf::sca_source("conv");
+        lsf_model *amodel = new lsf_model("adaptive_lsf_model");
+        sca_lsf::sca_tdf::sca_sink *sink = new sca_lsf::sca_tdf::sca_sink("sink");
+        recorder = new sample_recorder("recorder");
+
+        asrc->out(*srcOut);
+        conv->inp(*srcOut);
+        conv->y(*aIn);
+        amodel->in(*aIn);
+        amodel->out(*aOut);
+        sink->x(*aOut);
+        sink->outp(*sinkOut);
+        asrc->feedback(*sinkOut);
+        recorder->in(*sinkOut);
+    }
+
     sca_util::sca_trace_file* tf = sca_util::sca_create_tabular_trace_file("trace.csv");
     sca_util::sca_trace(tf, in, "input");
     sca_util::sca_trace(tf, out, "output");
     sc_core::sc_start(1.0, sc_core::SC_SEC);
     sca_util::sca_close_tabular_trace_file(tf);
 
+    if(adaptive)
+    {
+        std::cout << "Fixed timestep:    " << reference->time.size()
+                  << " timesteps" << std::endl;
+        std::cout << "Adaptive timestep: " << asrc->steps
+                  << " timesteps, max. deviation "
+                  << recorder->max_deviation(*reference) << std::endl;
+    }
+
     return 0;
 }
 
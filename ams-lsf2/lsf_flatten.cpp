@@ -0,0 +1,372 @@
+#include "lsf_flatten.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <set>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+
+std::vector<double> add(const std::vector<double>& a,
+                        const std::vector<double>& b)
+{
+  std::vector<double> r(std::max(a.size(), b.size()), 0.0);
+  for (unsigned int i = 0; i < a.size(); i++) r[i] += a[i];
+  for (unsigned int i = 0; i < b.size(); i++) r[i] += b[i];
+  return r;
+}
+
+std::vector<double> multiply(const std::vector<double>& a,
+                             const std::vector<double>& b)
+{
+  std::vector<double> r(a.size() + b.size() - 1, 0.0);
+  for (unsigned int i = 0; i < a.size(); i++)
+    for (unsigned int j = 0; j < b.size(); j++)
+      r[i + j] += a[i] * b[j];
+  return r;
+}
+
+std::vector<double> scale(const std::vector<double>& a, double k)
+{
+  std::vector<double> r(a);
+  for (double& c : r) c *= k;
+  return r;
+}
+
+// Signal flow graph: transfer function of every edge from a signal to a
+// signal, every signal is the sum of its incoming edges.
+typedef std::map<const sc_core::sc_object*,
+                 std::map<const sc_core::sc_object*, lsf_tf> > graph;
+
+void connect(std::map<const sc_core::sc_object*, lsf_tf>& edges,
+             const sc_core::sc_object* to, const lsf_tf& h)
+{
+  auto e = edges.find(to);
+  if (e == edges.end())
+    edges.insert(std::make_pair(to, h));
+  else
+    e->second = e->second + h;  // parallel paths
+}
+
+void collect(const std::vector<sc_core::sc_object*>& objects,
+             std::vector<sc_core::sc_object*>& result)
+{
+  for (sc_core::sc_object* o : objects)
+  {
+    result.push_back(o);
+    collect(o->get_child_objects(), result);
+  }
+}
+
+// Signal that a port is bound to:
+template <class PORT>
+const sc_core::sc_object* signal(PORT& port)
+{
+  return dynamic_cast<const sc_core::sc_object*>(port.get_interface());
+}
+
+} // namespace
+
+lsf_tf::lsf_tf(const std::vector<double>& num_, const std::vector<double>& den_)
+: num(num_), den(den_)
+{
+  normalize();
+}
+
+lsf_tf lsf_tf::gain(double k)
+{
+  return lsf_tf({k}, {1.0});
+}
+
+lsf_tf lsf_tf::integ(double k)
+{
+  return lsf_tf({k}, {0.0, 1.0});
+}
+
+lsf_tf lsf_tf::dot(double k)
+{
+  return lsf_tf({0.0, k}, {1.0});
+}
+
+lsf_tf lsf_tf::ltf(const sca_util::sca_vector<double>& num_,
+                   const sca_util::sca_vector<double>& den_)
+{
+  std::vector<double> n(num_.length()), d(den_.length());
+  for (unsigned int i = 0; i < n.size(); i++) n[i] = num_(i);
+  for (unsigned int i = 0; i < d.size(); i++) d[i] = den_(i);
+  return lsf_tf(n, d);
+}
+
+lsf_tf lsf_tf::feedback(const lsf_tf& g, const lsf_tf& h)
+{
+  //   Ng/Dg            Ng*Dh
+  // ---------- = ---------------
+  // 1 + GH         Dg*Dh + Ng*Nh
+  return lsf_tf(multiply(g.num, h.den),
+                add(multiply(g.den, h.den), multiply(g.num, h.num)));
+}
+
+lsf_tf lsf_tf::flatten(const std::vector<sc_core::sc_object*>& objects,
+                       const sca_lsf::sca_signal& in,
+                       const sca_lsf::sca_signal& out)
+{
+  std::vector<sc_core::sc_object*> all;
+  collect(objects, all);
+
+  // The signals are eliminated in the order of the primitives, which keeps
+  // the common factors of a chain together, e.g. the 1/s of the integrator
+  // with the other terms of the sum it feeds:
+  graph g;
+  std::vector<const sc_core::sc_object*> internal;
+  std::set<const sc_core::sc_object*> known;
+  auto edge = [&](const sc_core::sc_object* from, const sc_core::sc_object* to,
+                  const lsf_tf& h)
+  {
+    if (from == nullptr || to == nullptr)
+      SC_REPORT_FATAL("lsf_tf", "flatten() needs bound ports, call it after the elaboration");
+    if (to == &in) return;  // in is the source
+    connect(g[from], to, h);
+    for (const sc_core::sc_object* s : {from, to})
+      if (s != &in && s != &out && known.insert(s).second)
+        internal.push_back(s);
+  };
+
+  for (sc_core::sc_object* o : all)
+  {
+    if (sca_lsf::sca_gain* p = dynamic_cast<sca_lsf::sca_gain*>(o))
+    {
+      edge(signal(p->x), signal(p->y), gain(p->k.get()));
+    }
+    else if (sca_lsf::sca_integ* p = dynamic_cast<sca_lsf::sca_integ*>(o))
+    {
+      edge(signal(p->x), signal(p->y), integ(p->k.get()));
+    }
+    else if (sca_lsf::sca_dot* p = dynamic_cast<sca_lsf::sca_dot*>(o))
+    {
+      edge(signal(p->x), signal(p->y), dot(p->k.get()));
+    }
+    else if (sca_lsf::sca_add* p = dynamic_cast<sca_lsf::sca_add*>(o))
+    {
+      edge(signal(p->x1), signal(p->y), gain(p->k1.get()));
+      edge(signal(p->x2), signal(p->y), gain(p->k2.get()));
+    }
+    else if (sca_lsf::sca_sub* p = dynamic_cast<sca_lsf::sca_sub*>(o))
+    {
+      edge(signal(p->x1), signal(p->y), gain(p->k1.get()));
+      edge(signal(p->x2), signal(p->y), gain(-p->k2.get()));
+    }
+    else if (sca_lsf::sca_ltf_nd* p = dynamic_cast<sca_lsf::sca_ltf_nd*>(o))
+    {
+      if (p->delay.get() != sc_core::SC_ZERO_TIME)
+        SC_REPORT_ERROR("lsf_tf", (std::string(o->name())
+                        + ": the delay of a sca_ltf_nd cannot be flattened").c_str());
+      edge(signal(p->x), signal(p->y), ltf(p->num.get(), p->den.get()));
+    }
+    else if (dynamic_cast<sca_lsf::sca_module*>(o))
+    {
+      SC_REPORT_ERROR("lsf_tf", (std::string(o->name())
+                      + " is no linear LSF primitive and cannot be flattened").c_str());
+    }
+  }
+
+  // Eliminate every internal signal n: each path a -> n -> b becomes an
+  // edge a -> b, a loop n -> n is resolved by the factor 1 / (1 - loop).
+  for (const sc_core::sc_object* n : internal)
+  {
+    auto& successors = g[n];
+    lsf_tf loop = gain(1.0);
+    auto self = successors.find(n);
+    if (self != successors.end())
+    {
+      loop = gain(1.0) / (gain(1.0) - self->second);
+      successors.erase(self);
+    }
+
+    for (auto& a : g)
+    {
+      auto e = a.second.find(n);
+      if (a.first == n || e == a.second.end()) continue;
+
+      lsf_tf h = e->second * loop;
+      a.second.erase(e);
+      for (auto& b : successors) connect(a.second, b.first, h * b.second);
+    }
+    g.erase(n);
+  }
+
+  // out = direct * in + loop * out:
+  auto direct = g[&in].find(&out);
+  if (direct == g[&in].end()) return gain(0.0);
+
+  auto self = g[&out].find(&out);
+  if (self == g[&out].end()) return direct->second;
+
+  return direct->second / (gain(1.0) - self->second);
+}
+
+lsf_tf lsf_tf::flatten(const sc_core::sc_object& module,
+                       const sca_lsf::sca_signal& in,
+                       const sca_lsf::sca_signal& out)
+{
+  return flatten(module.get_child_objects(), in, out);
+}
+
+lsf_tf lsf_tf::flatten(const std::function<void(sca_lsf::sca_signal& in,
+                                                sca_lsf::sca_signal& out)>& build)
+{
+  int fd[2];
+  if (pipe(fd) != 0)
+    SC_REPORT_FATAL("lsf_tf", "cannot create a pipe for the elaboration");
+
+  std::cout.flush();
+  fflush(stdout);
+
+  pid_t child = fork();
+  if (child < 0)
+    SC_REPORT_FATAL("lsf_tf", "cannot fork the elaboration");
+
+  if (child == 0)
+  {
+    // The child reports through the pipe only:
+    close(fd[0]);
+    int null = open("/dev/null", O_WRONLY);
+    if (null >= 0) dup2(null, STDOUT_FILENO);
+
+    std::vector<double> result;
+    try
+    {
+      sca_lsf::sca_signal in("in"), out("out");
+      sca_lsf::sca_source src("src");
+        src.y(in);
+        src.set_timestep(1.0, sc_core::SC_SEC);
+
+      build(in, out);
+
+      // Completes the bindings:
+      sc_core::sc_start(sc_core::SC_ZERO_TIME);
+
+      std::vector<sc_core::sc_object*> objects;
+      for (sc_core::sc_object* o : sc_core::sc_get_top_level_objects())
+        if (o != &src) objects.push_back(o);
+
+      lsf_tf h = flatten(objects, in, out);
+      result.push_back(h.num.size());
+      result.insert(result.end(), h.num.begin(), h.num.end());
+      result.push_back(h.den.size());
+      result.insert(result.end(), h.den.begin(), h.den.end());
+    }
+    catch (...)
+    {
+      _exit(1);
+    }
+
+    const char* p = reinterpret_cast<const char*>(result.data());
+    size_t left = result.size() * sizeof(double);
+    while (left > 0)
+    {
+      ssize_t n = write(fd[1], p, left);
+      if (n <= 0) _exit(1);
+      p += n;
+      left -= n;
+    }
+    _exit(0);
+  }
+
+  close(fd[1]);
+  std::vector<char> buffer;
+  char chunk[4096];
+  ssize_t n;
+  while ((n = read(fd[0], chunk, sizeof(chunk))) > 0)
+    buffer.insert(buffer.end(), chunk, chunk + n);
+  close(fd[0]);
+
+  int status = 0;
+  waitpid(child, &status, 0);
+
+  std::vector<double> result(buffer.size() / sizeof(double));
+  std::copy(buffer.begin(), buffer.begin() + result.size() * sizeof(double),
+            reinterpret_cast<char*>(result.data()));
+
+  // num size, num, den size, den:
+  unsigned int nums = result.empty() ? 0 : result[0];
+  unsigned int dens = result.size() > nums + 1 ? result[nums + 1] : 0;
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || nums == 0
+      || dens == 0 || result.size() != nums + dens + 2)
+  {
+    SC_REPORT_FATAL("lsf_tf", "the elaboration for the flattening failed");
+  }
+
+  return lsf_tf(std::vector<double>(result.begin() + 1, result.begin() + 1 + nums),
+                std::vector<double>(result.begin() + 2 + nums, result.end()));
+}
+
+lsf_tf lsf_tf::operator+(const lsf_tf& other) const
+{
+  if (den == other.den) // e.g. gain + dot, no need to expand
+    return lsf_tf(add(num, other.num), den);
+
+  return lsf_tf(add(multiply(num, other.den), multiply(other.num, den)),
+                multiply(den, other.den));
+}
+
+lsf_tf lsf_tf::operator-(const lsf_tf& other) const
+{
+  return *this + lsf_tf(scale(other.num, -1.0), other.den);
+}
+
+lsf_tf lsf_tf::operator*(const lsf_tf& other) const
+{
+  return lsf_tf(multiply(num, other.num), multiply(den, other.den));
+}
+
+lsf_tf lsf_tf::operator/(const lsf_tf& other) const
+{
+  if (other.num.size() == 1 && other.num[0] == 0.0)
+    SC_REPORT_ERROR("lsf_tf", "division by zero, e.g. an algebraic loop of gain 1");
+
+  if (den == other.den) // e.g. G / (1 + G), the denominators cancel
+    return lsf_tf(num, other.num);
+
+  return lsf_tf(multiply(num, other.den), multiply(den, other.num));
+}
+
+void lsf_tf::normalize()
+{
+  // Drop vanishing coefficients of the highest powers:
+  while (num.size() > 1 && num.back() == 0.0) num.pop_back();
+  while (den.size() > 1 && den.back() == 0.0) den.pop_back();
+
+  // Cancel common factors s, e.g. of (kd s^2 + kp s) / s:
+  while (num.size() > 1 && den.size() > 1 && num[0] == 0.0 && den[0] == 0.0)
+  {
+    num.erase(num.begin());
+    den.erase(den.begin());
+  }
+
+  // Monic denominator:
+  double lead = den.back();
+  if (lead != 0.0 && lead != 1.0)
+  {
+    num = scale(num, 1.0 / lead);
+    den = scale(den, 1.0 / lead);
+  }
+}
+
+lsf_flat::lsf_flat( sc_core::sc_module_name nm, const lsf_tf& h )
+: x("x"), y("y")
+{
+  num.resize(h.num.size());
+  den.resize(h.den.size());
+  for (unsigned int i = 0; i < h.num.size(); i++) num(i) = h.num[i];
+  for (unsigned int i = 0; i < h.den.size(); i++) den(i) = h.den[i];
+
+  ltf1 = new sca_lsf::sca_ltf_nd("ltf1", num, den);
+  ltf1->x(x);
+  ltf1->y(y);
+}
@@ -0,0 +1,80 @@
+#ifndef _LSF_FLATTEN_H_
+#define _LSF_FLATTEN_H_
+
+#include <systemc-ams>
+
+#include <functional>
+#include <vector>
+
+// Transfer function algebra for flattening compositions of linear LSF
+// blocks. Every primitive is described by its transfer function
+// H(s) = N(s)/D(s) with ascending coefficients, i.e. num[0] belongs to s^0
+// like in sca_lsf::sca_ltf_nd. flatten() reads the primitives and their
+// bindings from an elaborated composition and collapses series
+// connections, sums and feedback loops into one transfer function, which is
+// then elaborated as a single sca_ltf_nd by lsf_flat.
+class lsf_tf
+{
+ public:
+  std::vector<double> num, den;
+
+  lsf_tf(const std::vector<double>& num_, const std::vector<double>& den_);
+
+  // Counterparts of the LSF primitives:
+  static lsf_tf gain(double k);   // sca_lsf::sca_gain:  k
+  static lsf_tf integ(double k);  // sca_lsf::sca_integ: k / s
+  static lsf_tf dot(double k);    // sca_lsf::sca_dot:   k * s
+  static lsf_tf ltf(const sca_util::sca_vector<double>& num_,
+                    const sca_util::sca_vector<double>& den_);
+
+  // Closed loop of forward path g with feedback path h at a sca_sub:
+  // g / (1 + g * h)
+  static lsf_tf feedback(const lsf_tf& g, const lsf_tf& h);
+
+  // Transfer function from signal in to signal out of the sca_gain,
+  // sca_integ, sca_dot, sca_add, sca_sub and sca_ltf_nd primitives among
+  // objects and their children. The signals are found through the port
+  // bindings, so call it after the elaboration. The internal signals are
+  // eliminated one after the other, in is the only source:
+  static lsf_tf flatten(const std::vector<sc_core::sc_object*>& objects,
+                        const sca_lsf::sca_signal& in,
+                        const sca_lsf::sca_signal& out);
+
+  static lsf_tf flatten(const sc_core::sc_object& module,
+                        const sca_lsf::sca_signal& in,
+                        const sca_lsf::sca_signal& out);
+
+  // Flattens the composition that build() instantiates between in and out.
+  // SystemC elaborates a design only once per process, therefore the
+  // composition is elaborated in a child process, which sends the transfer
+  // function back. Call it before anything else is instantiated, the child
+  // would elaborate that as well:
+  static lsf_tf flatten(const std::function<void(sca_lsf::sca_signal& in,
+                                                 sca_lsf::sca_signal& out)>& build);
+
+  unsigned int order() const { return den.size() - 1; }
+
+  lsf_tf operator+(const lsf_tf& other) const; // sca_lsf::sca_add
+  lsf_tf operator-(const lsf_tf& other) const; // sca_lsf::sca_sub
+  lsf_tf operator*(const lsf_tf& other) const; // series connection
+  lsf_tf operator/(const lsf_tf& other) const;
+
+ private:
+  void normalize();
+};
+
+// Single sca_ltf_nd that replaces a flattened composition of LSF blocks
+SC_MODULE(lsf_flat)
+{
+  sca_lsf::sca_in x;
+  sca_lsf::sca_out y;
+
+  sca_lsf::sca_ltf_nd* ltf1;
+
+  lsf_flat( sc_core::sc_module_name nm, const lsf_tf& h );
+
+ private:
+  sca_util::sca_vector<double> num, den;
+};
+
+#endif // _LSF_FLATTEN_H_
@@ -22,15 +22,190 @@
 
 #include <systemc-ams>
 
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
 #include "pid_controller.h"
 #include "ltf_nd_filter.h"
 #include "ltf_pid.h"
+#include "lsf_flatten.h"
+#include "../ams-lsf/adaptive_timestep.h"
+
+// Gains of the PID controller, shared by all models of the closed loop
+static const double kp = 350.0;
+static const double ki = 300.0;
+static const double kd = 50.0;
+
+// Counts the LSF primitives and signals, i.e. the size of the equation
+// system that the LSF solver has to set up:
+void count_lsf(const std::vector<sc_core::sc_object*>& objects,
+               unsigned int& primitives, unsigned int& signals)
+{
+  for (sc_core::sc_object* o : objects)
+  {
+    if (dynamic_cast<sca_lsf::sca_module*>(o)) primitives++;
+    if (dynamic_cast<sca_lsf::sca_signal*>(o)) signals++;
+    count_lsf(o->get_child_objects(), primitives, signals);
+  }
+}
+
+// Closed loop of sub, pid_controller and ltf_nd_filter with output out
+void closed_loop(const char* name, sca_lsf::sca_signal& in,
+                 sca_lsf::sca_signal& out)
+{
+  std::string prefix(name);
+  sca_lsf::sca_signal* error = new sca_lsf::sca_signal((prefix + "_error").c_str());
+  sca_lsf::sca_signal* pid_out = new sca_lsf::sca_signal((prefix + "_pid_out").c_str());
+
+  sca_lsf::sca_sub* sub = new sca_lsf::sca_sub((prefix + "_sub").c_str());
+    sub->x1(in);
+    sub->x2(out);
+    sub->y(*error);
+
+  pid_controller* pid = new pid_controller((prefix + "_pid").c_str(), kp, ki, kd);
+    pid->e(*error);
+    pid->u(*pid_out);
+
+  ltf_nd_filter* plant = new ltf_nd_filter((prefix + "_plant").c_str());
+    plant->x(*pid_out);
+    plant->y(out);
+}
+
+// Flattened counterpart of closed_loop(), read from the primitives and
+// bindings of an elaborated closed loop:
+lsf_tf flat_loop()
+{
+  return lsf_tf::flatten([](sca_lsf::sca_signal& in, sca_lsf::sca_signal& out)
+                         { closed_loop("loop", in, out); });
+}
+
+// Usage: ams-lsf2 composed|flat [simulation time in s]
+// Simulates only one variant of the closed loop without tracing and
+// reports the equation system size and the runtime.
+int benchmark(bool flat, double simulation_time)
+{
+  // Before anything is instantiated:
+  lsf_tf loop = flat ? flat_loop() : lsf_tf::gain(1.0);
+
+  sca_lsf::sca_signal in, out;
+
+  sca_lsf::sca_source src("src", 0.0, 1.0, 0.0, 0.0, 0.0,
+                          sca_core::sca_time(10, sc_core::SC_MS));
+    src.y(in);
+    src.set_timestep(10, sc_core::SC_MS);
+
+  if (flat)
+  {
+    lsf_flat* model = new lsf_flat("loop", loop);
+      model->x(in);
+      model->y(out);
+  }
+  else
+  {
+    closed_loop("composed", in, out);
+  }
+
+  unsigned int primitives = 0, signals = 0;
+  count_lsf(sc_core::sc_get_top_level_objects(), primitives, signals);
+
+  auto start = std::chrono::steady_clock::now();
+  sc_core::sc_start(simulation_time, sc_core::SC_SEC);
+  auto end = std::chrono::steady_clock::now();
+
+  std::cout << (flat ? "flat" : "composed")
+            << ": " << primitives << " LSF primitives, "
+            << signals << " LSF signals, "
+            << std::chrono::duration<double, std::milli>(end - start).count()
+            << " ms" << std::endl;
+
+  return 0;
+}
+
+// Usage: ams-lsf2 adaptive [simulation time in s]
+// Simulates the closed loop with the fixed timestep of 10ms as reference
+// and a second time with an adaptive timestep that resolves the step at
+// 10ms finely and grows in the following steady state.
+int adaptive(double simulation_time)
+{
+  sca_core::sca_time step_time(10, sc_core::SC_MS);
+
+  // Fixed timestep reference:
+  sca_lsf::sca_signal in, out;
+  sca_tdf::sca_signal<double> ref_out;
+
+  sca_lsf::sca_source src("src", 0.0, 1.0, 0.0, 0.0, 0.0, step_time);
+    src.y(in);
+    src.set_timestep(10, sc_core::SC_MS);
+
+  closed_loop("fixed", in, out);
+
+  sca_lsf::sca_tdf::sca_sink ref_sink("ref_sink");
+    ref_sink.x(out);
+    ref_sink.outp(ref_out);
+
+  sample_recorder reference("reference");
+    reference.in(ref_out);
+
+  // Adaptive timestep:
+  sca_lsf::sca_signal a_in, a_out;
+  sca_tdf::sca_signal<double> src_out, sink_out;
+
+  adaptive_source asrc("asrc",
+                       [step_time](double t)
+                       { return t >= step_time.to_seconds() ? 1.0 : 0.0; },
+                       {step_time},                            // Discontinuities
+                       sca_core::sca_time(1, sc_core::SC_MS),  // Minimal timestep
+                       sca_core::sca_time(1, sc_core::SC_SEC), // Maximal timestep
+                       1e-3);                                  // Tolerance
+    asrc.out(src_out);
+    asrc.feedback(sink_out);
+
+  sca_lsf::sca_tdf::sca_source conv("conv");
+    conv.inp(src_out);
+    conv.y(a_in);
+
+  closed_loop("adaptive", a_in, a_out);
+
+  sca_lsf::sca_tdf::sca_sink sink("sink");
+    sink.x(a_out);
+    sink.outp(sink_out);
+
+  sample_recorder recorder("recorder");
+    recorder.in(sink_out);
+
+  sc_core::sc_start(simulation_time, sc_core::SC_SEC);
+
+  std::cout << "Fixed timestep:    " << reference.time.size()
+            << " timesteps" << std::endl;
+  std::cout << "Adaptive timestep: " << asrc.steps
+            << " timesteps, max. deviation "
+            << recorder.max_deviation(reference) << std::endl;
+
+  return 0;
+}
 
 int sc_main(int argc, char* argv[])
 {
   sc_core::sc_set_time_resolution(1.0, sc_core::SC_FS);
-     
-  sca_lsf::sca_signal in, error, out1, out2, pid_out;
+
+  if (argc > 1 && strcmp(argv[1], "adaptive") == 0)
+  {
+    return adaptive(argc > 2 ? atof(argv[2]) : 100.0);
+  }
+
+  if (argc > 1)
+  {
+    return benchmark(strcmp(argv[1], "flat") == 0,
+                     argc > 2 ? atof(argv[2]) : 10000.0);
+  }
+
+  // Same closed loop as sub -> pid -> plant1 below, flattened into one
+  // sca_ltf_nd. The flattening elaborates a copy of the loop, so it comes
+  // before anything is instantiated:
+  lsf_tf loop = flat_loop();
+
+  sca_lsf::sca_signal in, error, out1, out2, out3, pid_out;
 
   double init_value = 0.0;
   double offset = 1.0;
@@ -49,7 +224,7 @@ int sc_main(int argc, char* argv[])
     sub.x2(out1);
     sub.y(error);
     
-  pid_controller pid("pid", 350.0, 300.0, 50.0); 
+  pid_controller pid("pid", kp, ki, kd); 
     pid.e(error);
     pid.u(pid_out);
   
@@ -57,15 +232,22 @@ int sc_main(int argc, char* argv[])
     plant.x(pid_out);
     plant.y(out1);
 
-  ltf_pid pidc("pidc", 350.0, 300.0, 50.0);
+  ltf_pid pidc("pidc", kp, ki, kd);
     pidc.x(in);
     pidc.y(out2);
 
+  lsf_flat flat("flat", loop);
+    flat.x(in);
+    flat.y(out3);
+
+  std::cout << "Flattened closed loop of order " << loop.order() << std::endl;
+
   // tracing
   sca_util::sca_trace_file* atf = sca_util::sca_create_tabular_trace_file("pid_controller");
   sca_util::sca_trace(atf, in, "in");
   sca_util::sca_trace(atf, out1, "out1");
   sca_util::sca_trace(atf, out2, "out2");
+  sca_util::sca_trace(atf, out3, "out3");
 
   std::cout << "Simulation started..." << std::endl;
 
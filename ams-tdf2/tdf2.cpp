@@ -1,12 +1,20 @@
 #include <systemc.h>
 #include <systemc-ams.h>
 
+#include "tdf_inspector.h"
+
+// Uncomment in order to print every activation, e.g. to follow the schedule.
+// The console output would dominate the host time profile:
+//#define PRINT_ACTIVATIONS
+
 SCA_TDF_MODULE(X)
 {
     public:
     sca_tdf::sca_out<double> out;
 
-    SCA_CTOR(X) {
+    tdf_activation_counter activations;
+
+    SCA_CTOR(X) : activations(name()) {
         set_timestep(sc_time(125,SC_US)); // 8kHz
     }
 
@@ -15,7 +23,10 @@ SCA_TDF_MODULE(X)
     }
 
     void processing() {
+        tdf_activation_scope scope(activations);
+#ifdef PRINT_ACTIVATIONS
         std::cout << name() << " " << sc_time_stamp() << std::endl;
+#endif
         out.write(5.0);
     }
 };
@@ -26,7 +37,9 @@ SCA_TDF_MODULE(A)
     sca_tdf::sca_in<double> in;
     sca_tdf::sca_out<double> out;
 
-    SCA_CTOR(A) {
+    tdf_activation_counter activations;
+
+    SCA_CTOR(A) : activations(name()) {
     }
 
     void set_attributes() {
@@ -35,8 +48,11 @@ SCA_TDF_MODULE(A)
     }
 
     void processing() {
+        tdf_activation_scope scope(activations);
         double tmp = in.read();
+#ifdef PRINT_ACTIVATIONS
         std::cout << name() << " " << sc_time_stamp() << std::endl;
+#endif
         for(unsigned long i = 0; i < 2; i++) {
             out.write(tmp, i);
             //std::cout << "A " << i << std::endl;
@@ -50,7 +66,9 @@ SCA_TDF_MODULE(B)
     sca_tdf::sca_in<double> in;
     sca_tdf::sca_out<double> out;
 
-    SCA_CTOR(B) {
+    tdf_activation_counter activations;
+
+    SCA_CTOR(B) : activations(name()) {
     }
 
     void set_attributes() {
@@ -59,7 +77,10 @@ SCA_TDF_MODULE(B)
     }
 
     void processing() {
+        tdf_activation_scope scope(activations);
+#ifdef PRINT_ACTIVATIONS
         std::cout << name() << " " << sc_time_stamp() << std::endl;
+#endif
         double tmp = in.read();
         for(unsigned long i = 0; i < 3; i++) {
             out.write(tmp, i);
@@ -74,7 +95,9 @@ SCA_TDF_MODULE(C)
     sca_tdf::sca_in<double> in;
     sca_tdf::sca_out<double> out;
 
-    SCA_CTOR(C) {
+    tdf_activation_counter activations;
+
+    SCA_CTOR(C) : activations(name()) {
     }
 
     void set_attributes() {
@@ -83,7 +106,10 @@ SCA_TDF_MODULE(C)
     }
 
     void processing() {
+        tdf_activation_scope scope(activations);
+#ifdef PRINT_ACTIVATIONS
         std::cout << name() << " " << sc_time_stamp() << std::endl;
+#endif
         out.write(in.read(0)+in.read(1), 0); // or read(1)
     }
 };
@@ -93,14 +119,19 @@ SCA_TDF_MODULE(Y)
     public:
     sca_tdf::sca_in<double> in;
 
-    SCA_CTOR(Y) {
+    tdf_activation_counter activations;
+
+    SCA_CTOR(Y) : activations(name()) {
     }
 
     void set_attributes() {
     }
 
     void processing() {
+        tdf_activation_scope scope(activations);
+#ifdef PRINT_ACTIVATIONS
         std::cout << name() << " " << sc_time_stamp() << std::endl;
+#endif
         in.read();
     }
 
@@ -138,6 +169,10 @@ int sc_main(int argc, char* argv[])
     sc_core::sc_start(1, sc_core::SC_SEC);
     sca_util::sca_close_vcd_trace_file(tf);
 
+    tdf_inspector inspector;
+    inspector.discover<double>();
+    inspector.report();
+
     return 0;
 }
 
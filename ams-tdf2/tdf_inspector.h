@@ -0,0 +1,424 @@
+#ifndef TDF_INSPECTOR_H
+#define TDF_INSPECTOR_H
+
+#include <systemc.h>
+#include <systemc-ams.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <numeric>
+#include <string>
+#include <vector>
+
+// Per module activation counter. Put it as a member into a TDF module and
+// construct it with name(), then open a tdf_activation_scope at the top of
+// processing(). The counters register themselves while they exist, such
+// that the inspector can find them again by the module name.
+class tdf_activation_counter
+{
+    public:
+    std::string module;
+    unsigned long long activations;
+    unsigned long long hostNs;
+
+    tdf_activation_counter(const char *module) :
+        module(module),
+        activations(0),
+        hostNs(0)
+    {
+        all().push_back(this);
+    }
+
+    tdf_activation_counter(const tdf_activation_counter&) = delete;
+
+    ~tdf_activation_counter()
+    {
+        std::vector<tdf_activation_counter*> &counters = all();
+        counters.erase(std::remove(counters.begin(), counters.end(), this),
+                       counters.end());
+    }
+
+    static std::vector<tdf_activation_counter*>& all()
+    {
+        static std::vector<tdf_activation_counter*> counters;
+        return counters;
+    }
+};
+
+// Measures the host time of one processing() call. Only a steady clock read
+// at begin and end, so the overhead stays in the order of some ten ns.
+class tdf_activation_scope
+{
+    public:
+    tdf_activation_scope(tdf_activation_counter &counter) :
+        counter(counter),
+        start(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~tdf_activation_scope()
+    {
+        auto end = std::chrono::steady_clock::now();
+        counter.hostNs += std::chrono::duration_cast<
+            std::chrono::nanoseconds>(end - start).count();
+        counter.activations++;
+    }
+
+    private:
+    tdf_activation_counter &counter;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Static multirate schedule inspector for a TDF cluster:
+//
+// The connections of the cluster are found by discover(), which follows the
+// port bindings after elaboration, further ones can be added with connect().
+// The rates and delays are read back from the ports, i.e. exactly the values
+// that the modules set in set_attributes(). From these the
+// balance equations q(producer) * rate(out) = q(consumer) * rate(in) are
+// solved, which gives the repetition vector q, and a valid firing order for
+// one cluster period is derived. Together with the activation counters this
+// shows which module dominates the host time of a cluster period.
+class tdf_inspector
+{
+    public:
+    tdf_inspector(double dominanceThreshold = 0.5) :
+        dominanceThreshold(dominanceThreshold)
+    {
+    }
+
+    // Adds an edge for every TDF signal of sample type T between an output
+    // and an input port in the hierarchy. Call it after the elaboration,
+    // when all ports are bound:
+    template <class T>
+    void discover()
+    {
+        std::vector<sc_core::sc_object*> objects;
+        collect(sc_core::sc_get_top_level_objects(), objects);
+
+        std::map<const sc_core::sc_object*, sca_tdf::sca_out<T>*> producers;
+        for(sc_core::sc_object *o : objects)
+        {
+            if(sca_tdf::sca_out<T> *out = dynamic_cast<sca_tdf::sca_out<T>*>(o))
+            {
+                producers[signal(*out)] = out;
+            }
+        }
+
+        for(sc_core::sc_object *o : objects)
+        {
+            if(sca_tdf::sca_in<T> *in = dynamic_cast<sca_tdf::sca_in<T>*>(o))
+            {
+                auto producer = producers.find(signal(*in));
+                if(producer != producers.end())
+                {
+                    connect(*producer->second, *in);
+                }
+            }
+        }
+    }
+
+    template <class T>
+    void connect(sca_tdf::sca_out<T> &out, sca_tdf::sca_in<T> &in)
+    {
+        edge e;
+        e.producer = addModule(out.get_parent_object()->name());
+        e.consumer = addModule(in.get_parent_object()->name());
+        e.outRate = [&out]() { return out.get_rate(); };
+        e.inRate = [&in]() { return in.get_rate(); };
+        e.delay = [&out, &in]() { return out.get_delay() + in.get_delay(); };
+        edges.push_back(e);
+    }
+
+    void report(std::ostream &os = std::cout)
+    {
+        if(!computeRepetitionVector() || !computeSchedule())
+        {
+            return;
+        }
+
+        os << std::endl << "TDF Cluster Schedule:" << std::endl;
+        os << std::endl << "Repetition Vector:" << std::endl;
+        for(unsigned int m = 0; m < modules.size(); m++)
+        {
+            os << "  q(" << modules[m] << ") = " << q[m] << std::endl;
+        }
+
+        os << std::endl << "Static Schedule (one cluster period):" << std::endl;
+        os << " ";
+        for(unsigned int m : schedule)
+        {
+            os << " " << modules[m];
+        }
+        os << std::endl;
+
+        printProfile(os);
+    }
+
+    private:
+    struct edge
+    {
+        unsigned int producer;
+        unsigned int consumer;
+        std::function<unsigned long()> outRate;
+        std::function<unsigned long()> inRate;
+        std::function<unsigned long()> delay;
+    };
+
+    double dominanceThreshold;
+    std::vector<std::string> modules;
+    std::vector<edge> edges;
+    std::vector<unsigned long> q;
+    std::vector<unsigned int> schedule;
+
+    static void collect(const std::vector<sc_core::sc_object*> &objects,
+                        std::vector<sc_core::sc_object*> &result)
+    {
+        for(sc_core::sc_object *o : objects)
+        {
+            result.push_back(o);
+            collect(o->get_child_objects(), result);
+        }
+    }
+
+    // Signal that a port is bound to:
+    template <class PORT>
+    static const sc_core::sc_object* signal(PORT &port)
+    {
+        return dynamic_cast<const sc_core::sc_object*>(port.get_interface());
+    }
+
+    static unsigned long gcd(unsigned long a, unsigned long b)
+    {
+        while(b != 0)
+        {
+            unsigned long t = a % b;
+            a = b;
+            b = t;
+        }
+        return a;
+    }
+
+    unsigned int addModule(const std::string &name)
+    {
+        for(unsigned int m = 0; m < modules.size(); m++)
+        {
+            if(modules[m] == name)
+            {
+                return m;
+            }
+        }
+        modules.push_back(name);
+        return modules.size() - 1;
+    }
+
+    bool computeRepetitionVector()
+    {
+        // Solve the balance equations with fractions num/den, starting
+        // with q = 1 for the first module and propagating along the edges:
+        std::vector<unsigned long> num(modules.size(), 0);
+        std::vector<unsigned long> den(modules.size(), 1);
+
+        if(modules.empty())
+        {
+            return false;
+        }
+
+        num[0] = 1;
+        bool changed = true;
+        while(changed)
+        {
+            changed = false;
+            for(const edge &e : edges)
+            {
+                unsigned int from = e.producer;
+                unsigned int to = e.consumer;
+                unsigned long produced = e.outRate();
+                unsigned long consumed = e.inRate();
+
+                if(num[from] == 0 && num[to] == 0)
+                {
+                    continue;
+                }
+                if(num[from] == 0) // Propagate backwards
+                {
+                    std::swap(from, to);
+                    std::swap(produced, consumed);
+                }
+
+                unsigned long n = num[from] * produced;
+                unsigned long d = den[from] * consumed;
+                unsigned long g = gcd(n, d);
+                n /= g;
+                d /= g;
+
+                if(num[to] == 0)
+                {
+                    num[to] = n;
+                    den[to] = d;
+                    changed = true;
+                }
+                else if(num[to] != n || den[to] != d)
+                {
+                    SC_REPORT_WARNING("tdf_inspector",
+                        "Inconsistent rates, no static schedule exists");
+                    return false;
+                }
+            }
+        }
+
+        // Scale to the smallest integer solution:
+        unsigned long l = 1;
+        for(unsigned int m = 0; m < modules.size(); m++)
+        {
+            if(num[m] == 0)
+            {
+                SC_REPORT_WARNING("tdf_inspector", "Cluster is not connected");
+                return false;
+            }
+            l = l / gcd(l, den[m]) * den[m];
+        }
+
+        unsigned long g = 0;
+        q.assign(modules.size(), 0);
+        for(unsigned int m = 0; m < modules.size(); m++)
+        {
+            q[m] = num[m] * (l / den[m]);
+            g = gcd(g, q[m]);
+        }
+        for(unsigned long &r : q)
+        {
+            r /= g;
+        }
+        return true;
+    }
+
+    bool computeSchedule()
+    {
+        // Sweep over the modules and fire each one that has enough samples
+        // on all of its inputs, until every module m was fired q(m) times:
+        std::vector<unsigned long> tokens(edges.size());
+        std::vector<unsigned long> fired(modules.size(), 0);
+        unsigned long total = std::accumulate(q.begin(), q.end(), 0ul);
+
+        for(unsigned int i = 0; i < edges.size(); i++)
+        {
+            tokens[i] = edges[i].delay();
+        }
+
+        schedule.clear();
+        while(schedule.size() < total)
+        {
+            bool progress = false;
+            for(unsigned int m = 0; m < modules.size(); m++)
+            {
+                if(fired[m] == q[m] || !ready(m, tokens))
+                {
+                    continue;
+                }
+
+                for(unsigned int i = 0; i < edges.size(); i++)
+                {
+                    if(edges[i].consumer == m)
+                    {
+                        tokens[i] -= edges[i].inRate();
+                    }
+                    if(edges[i].producer == m)
+                    {
+                        tokens[i] += edges[i].outRate();
+                    }
+                }
+                fired[m]++;
+                schedule.push_back(m);
+                progress = true;
+            }
+
+            if(!progress)
+            {
+                SC_REPORT_WARNING("tdf_inspector",
+                    "Cluster deadlocks, insert delays in the feedback loops");
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool ready(unsigned int m, const std::vector<unsigned long> &tokens)
+    {
+        for(unsigned int i = 0; i < edges.size(); i++)
+        {
+            if(edges[i].consumer == m && tokens[i] < edges[i].inRate())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void printProfile(std::ostream &os)
+    {
+        std::vector<double> costPerPeriod(modules.size(), 0.0);
+        std::vector<tdf_activation_counter*> counter(modules.size(), nullptr);
+        double periodCost = 0.0;
+
+        for(unsigned int m = 0; m < modules.size(); m++)
+        {
+            for(tdf_activation_counter *c : tdf_activation_counter::all())
+            {
+                if(c->module == modules[m])
+                {
+                    counter[m] = c;
+                }
+            }
+
+            if(counter[m] != nullptr && counter[m]->activations > 0)
+            {
+                double average = double(counter[m]->hostNs)
+                               / counter[m]->activations;
+                costPerPeriod[m] = average * q[m];
+                periodCost += costPerPeriod[m];
+            }
+        }
+
+        os << std::endl << "Host Time Profile:" << std::endl;
+        os << std::left << "  "
+           << std::setw(12) << "Module"
+           << std::right
+           << std::setw(14) << "Activations"
+           << std::setw(14) << "ns/Act."
+           << std::setw(14) << "ns/Period"
+           << std::setw(10) << "Share" << std::endl;
+
+        for(unsigned int m = 0; m < modules.size(); m++)
+        {
+            os << std::left << "  " << std::setw(12) << modules[m] << std::right;
+
+            if(counter[m] == nullptr || counter[m]->activations == 0)
+            {
+                os << std::setw(14) << "-" << std::endl;
+                continue;
+            }
+
+            double share = periodCost > 0.0 ? costPerPeriod[m] / periodCost
+                                            : 0.0;
+
+            os << std::setw(14) << counter[m]->activations
+               << std::setw(14) << std::fixed << std::setprecision(1)
+               << double(counter[m]->hostNs) / counter[m]->activations
+               << std::setw(14) << costPerPeriod[m]
+               << std::setw(9) << share * 100.0 << "%";
+
+            if(share > dominanceThreshold)
+            {
+                os << "  <-- dominates cluster period";
+            }
+            os << std::endl;
+        }
+        os << std::defaultfloat;
+    }
+};
+
+#endif // TDF_INSPECTOR_H
@@ -0,0 +1,12 @@
+#!/usr/bin/env sh
+# Throughput of the generated 10k gate not_chain with 1, 64 and 256 lanes,
+# and of the RS latch with 1000 vectors.
+# Usage: ./benchmark.sh <path to bit_parallel_gates binary>
+BIN=${1:-./bit_parallel_gates}
+
+$BIN latch 1000
+
+for lanes in bool 64 256
+do
+    $BIN $lanes 10000 1000
+done
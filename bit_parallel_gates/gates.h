@@ -0,0 +1,81 @@
+/*
+ * Copyright 2017 Matthias Jung
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GATES_H
+#define GATES_H
+
+#include <systemc.h>
+
+#include "lanes.h"
+
+// Bit-parallel variants of the gate modules of not_chain and feedback_loop.
+// W is bool, uint64_t or lanes256, see lanes.h.
+template <class W>
+SC_MODULE(NOT)
+{
+    sc_in<W> in;
+    sc_out<W> out;
+
+    SC_CTOR(NOT) : in("in"), out("out")
+    {
+        SC_METHOD(process);
+        sensitive << in;
+    }
+
+    void process()
+    {
+        out.write(inv(in.read()));
+    }
+};
+
+template <class W>
+SC_MODULE(rslatch)
+{
+    sc_in<W> S;
+    sc_in<W> R;
+    sc_out<W> Q;
+    sc_out<W> N;
+
+    SC_CTOR(rslatch) : S("S"), R("R"), Q("Q"), N("N")
+    {
+        SC_METHOD(process);
+        sensitive << S << R << Q << N;
+    }
+
+    void process()
+    {
+        // A lane with S=R=1 followed by S=R=0 oscillates like the single
+        // bit latch, and keeps all other lanes of the word in the loop.
+        Q.write(nor(R.read(), N.read())); // Nor Gate
+        N.write(nor(S.read(), Q.read())); // Nor Gate
+    }
+};
+
+#endif // GATES_H
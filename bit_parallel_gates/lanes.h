@@ -0,0 +1,176 @@
+/*
+ * Copyright 2017 Matthias Jung
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LANES_H
+#define LANES_H
+
+#include <systemc.h>
+
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+// Signal values for bit-parallel simulation: every bit lane of a word is an
+// independent simulation of the same circuit, e.g. for a different input
+// pattern or a different injected fault. bool is the ordinary single-lane
+// case, uint64_t carries 64 lanes and lanes256 carries 256 lanes. The loops
+// over the four words of lanes256 are vectorized by the compiler to AVX2
+// instructions if AVX2 is enabled (cmake -DBIT_PARALLEL_AVX2=ON).
+struct alignas(32) lanes256
+{
+    uint64_t w[4];
+
+    // All four words are set to v
+    explicit lanes256(uint64_t v = 0)
+    {
+        for(int i = 0; i < 4; i++)
+        {
+            w[i] = v;
+        }
+    }
+
+    lanes256 operator~() const
+    {
+        lanes256 r;
+        for(int i = 0; i < 4; i++)
+        {
+            r.w[i] = ~w[i];
+        }
+        return r;
+    }
+
+    lanes256 operator|(const lanes256 &o) const
+    {
+        lanes256 r;
+        for(int i = 0; i < 4; i++)
+        {
+            r.w[i] = w[i] | o.w[i];
+        }
+        return r;
+    }
+
+    lanes256 operator&(const lanes256 &o) const
+    {
+        lanes256 r;
+        for(int i = 0; i < 4; i++)
+        {
+            r.w[i] = w[i] & o.w[i];
+        }
+        return r;
+    }
+
+    lanes256 operator^(const lanes256 &o) const
+    {
+        lanes256 r;
+        for(int i = 0; i < 4; i++)
+        {
+            r.w[i] = w[i] ^ o.w[i];
+        }
+        return r;
+    }
+
+    bool operator==(const lanes256 &o) const
+    {
+        return ((w[0] ^ o.w[0]) | (w[1] ^ o.w[1])
+              | (w[2] ^ o.w[2]) | (w[3] ^ o.w[3])) == 0;
+    }
+
+    bool operator!=(const lanes256 &o) const
+    {
+        return !(*this == o);
+    }
+};
+
+// Required by sc_signal<lanes256>:
+inline std::ostream& operator<<(std::ostream &os, const lanes256 &v)
+{
+    std::ios::fmtflags flags = os.flags();
+    os << std::hex << std::setfill('0');
+    for(int i = 3; i >= 0; i--)
+    {
+        os << std::setw(16) << v.w[i];
+    }
+    os.flags(flags);
+    return os;
+}
+
+inline void sc_trace(sc_trace_file *tf, const lanes256 &v,
+                     const std::string &name)
+{
+    for(int i = 0; i < 4; i++)
+    {
+        sc_trace(tf, v.w[i], name + ".w" + std::to_string(i));
+    }
+}
+
+// Gate functions for all lane types:
+inline bool inv(bool a)                       { return !a; }
+inline uint64_t inv(uint64_t a)               { return ~a; }
+inline lanes256 inv(const lanes256 &a)        { return ~a; }
+
+inline bool nor(bool a, bool b)               { return !(a || b); }
+inline uint64_t nor(uint64_t a, uint64_t b)   { return ~(a | b); }
+inline lanes256 nor(const lanes256 &a, const lanes256 &b) { return ~(a | b); }
+
+// Access to single lanes:
+template <class W> struct lane_traits;
+
+template <> struct lane_traits<bool>
+{
+    static const unsigned int width = 1;
+    static bool get(bool v, unsigned int) { return v; }
+    static void set(bool &v, unsigned int, bool b) { v = b; }
+};
+
+template <> struct lane_traits<uint64_t>
+{
+    static const unsigned int width = 64;
+    static bool get(uint64_t v, unsigned int i) { return (v >> i) & 1; }
+    static void set(uint64_t &v, unsigned int i, bool b)
+    {
+        v = (v & ~(uint64_t(1) << i)) | (uint64_t(b) << i);
+    }
+};
+
+template <> struct lane_traits<lanes256>
+{
+    static const unsigned int width = 256;
+    static bool get(const lanes256 &v, unsigned int i)
+    {
+        return lane_traits<uint64_t>::get(v.w[i / 64], i % 64);
+    }
+    static void set(lanes256 &v, unsigned int i, bool b)
+    {
+        lane_traits<uint64_t>::set(v.w[i / 64], i % 64, b);
+    }
+};
+
+#endif // LANES_H
@@ -0,0 +1,211 @@
+/*
+ * Copyright 2017 Matthias Jung
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <systemc.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gates.h"
+
+template <class W>
+W randomLanes(std::mt19937_64 &generator)
+{
+    W v = W();
+    for(unsigned int i = 0; i < lane_traits<W>::width; i++)
+    {
+        lane_traits<W>::set(v, i, generator() & 1);
+    }
+    return v;
+}
+
+// Applies random patterns to a not_chain with the given number of stages
+// and reports the throughput in patterns per second of host time. Every
+// pattern of W carries lane_traits<W>::width independent patterns.
+template <class W>
+int chain(unsigned int stages, unsigned int vectors)
+{
+    sc_signal<W> A("A");
+    sc_vector<sc_signal<W> > net("net", stages);
+    sc_vector<NOT<W> > gates("gate", stages);
+
+    //        net0  net1         net(n-1)
+    // A--NOT0--NOT1-- ... --NOT(n-1)--
+    for(unsigned int i = 0; i < stages; i++)
+    {
+        gates[i].in(i == 0 ? A : net[i-1]);
+        gates[i].out(net[i]);
+    }
+
+    std::mt19937_64 generator(42);
+    std::vector<W> patterns(vectors);
+    for(unsigned int i = 0; i < vectors; i++)
+    {
+        patterns[i] = randomLanes<W>(generator);
+    }
+
+    unsigned int mismatches = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for(unsigned int i = 0; i < vectors; i++)
+    {
+        W p = patterns[i];
+        A.write(p);
+        sc_start(1, SC_NS);
+
+        W expected = stages % 2 ? inv(p) : p;
+        if(net[stages-1].read() != expected)
+        {
+            mismatches++;
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    double time = std::chrono::duration<double>(end - start).count();
+    double total = double(vectors) * lane_traits<W>::width;
+
+    std::cout << lane_traits<W>::width << " lane(s), "
+              << stages << " gates, " << vectors << " vectors" << std::endl
+              << "    patterns:       " << total << std::endl
+              << "    host time:      " << time << " s" << std::endl
+              << "    patterns/s:     " << total / time << std::endl
+              << "    gate evals/s:   " << total * stages / time << std::endl
+              << "    mismatches:     " << mismatches << std::endl;
+
+    return mismatches == 0 ? 0 : 1;
+}
+
+// Checks every lane of a bit-parallel rslatch against a single bit rslatch
+// that gets the same random set/reset sequence. S=R=1 is excluded, since a
+// following S=R=0 lets the latch oscillate (see feedback_loop).
+template <class W>
+int latch(unsigned int vectors)
+{
+    const unsigned int width = lane_traits<W>::width;
+
+    sc_signal<W> S("S"), R("R"), Q("Q"), N("N");
+    rslatch<W> parallel("parallel");
+    parallel.S(S);
+    parallel.R(R);
+    parallel.Q(Q);
+    parallel.N(N);
+
+    sc_vector<sc_signal<bool> > s("s", width), r("r", width);
+    sc_vector<sc_signal<bool> > q("q", width), n("n", width);
+    sc_vector<rslatch<bool> > single("single", width);
+    for(unsigned int i = 0; i < width; i++)
+    {
+        single[i].S(s[i]);
+        single[i].R(r[i]);
+        single[i].Q(q[i]);
+        single[i].N(n[i]);
+    }
+
+    std::mt19937_64 generator(42);
+    unsigned int mismatches = 0;
+
+    // Start in reset state, i.e. R=1 in all lanes:
+    W set = W();
+    W reset = inv(W());
+
+    for(unsigned int v = 0; v <= vectors; v++)
+    {
+        S.write(set);
+        R.write(reset);
+        for(unsigned int i = 0; i < width; i++)
+        {
+            s[i].write(lane_traits<W>::get(set, i));
+            r[i].write(lane_traits<W>::get(reset, i));
+        }
+
+        sc_start(1, SC_NS);
+
+        for(unsigned int i = 0; i < width; i++)
+        {
+            if(lane_traits<W>::get(Q.read(), i) != q[i].read()
+               || lane_traits<W>::get(N.read(), i) != n[i].read())
+            {
+                mismatches++;
+            }
+        }
+
+        set = randomLanes<W>(generator);
+        reset = randomLanes<W>(generator) & inv(set);
+    }
+
+    std::cout << width << " lane rslatch, " << vectors << " vectors"
+              << std::endl
+              << "    mismatches:     " << mismatches << std::endl;
+
+    return mismatches == 0 ? 0 : 1;
+}
+
+int sc_main(int argc, char *argv[])
+{
+    // Usage: bit_parallel_gates [bool|64|256] [stages] [vectors]
+    //        bit_parallel_gates latch [vectors]
+    std::string mode = argc > 1 ? argv[1] : "64";
+
+    if(mode == "latch")
+    {
+        return latch<uint64_t>(argc > 2 ? atoi(argv[2]) : 1000);
+    }
+
+    unsigned int stages = argc > 2 ? atoi(argv[2]) : 10000;
+    unsigned int vectors = argc > 3 ? atoi(argv[3]) : 1000;
+
+    if(stages == 0)
+    {
+        std::cerr << "At least one stage is required" << std::endl;
+        return 1;
+    }
+
+    if(mode == "bool")
+    {
+        return chain<bool>(stages, vectors);
+    }
+    else if(mode == "64")
+    {
+        return chain<uint64_t>(stages, vectors);
+    }
+    else if(mode == "256")
+    {
+        return chain<lanes256>(stages, vectors);
+    }
+
+    std::cerr << "Usage: " << argv[0]
+              << " [bool|64|256] [stages] [vectors]" << std::endl
+              << "       " << argv[0] << " latch [vectors]" << std::endl;
+    return 1;
+}
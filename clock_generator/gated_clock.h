@@ -0,0 +1,311 @@
+/*
+ * Copyright 2017 Matthias Jung
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GATED_CLOCK_H
+#define GATED_CLOCK_H
+
+#include <systemc.h>
+#include <set>
+
+// Clock channel for cycle-based models. In contrast to sc_clock or the
+// clockGenerator, which toggle a signal twice per period, only the rising
+// edges are materialized: one event per cycle while the clock is in use,
+// and none at all while it is gated. The negedge event is never notified.
+//
+// It implements sc_signal_in_if<bool>, so it can be bound to sc_in<bool>
+// ports with static sensitivity to clk.pos(). Cycle-based processes do not
+// need the event at all: wait_cycles(n) waits for the n-th next rising edge
+// with a single timed wait, i.e. N idle cycles are skipped with one
+// wait(N * period).
+//
+// The clock gates itself when no process uses it. Users are the processes
+// that are statically sensitive to the clock, which ask for its events
+// during the elaboration, the processes that are waiting in wait_cycles()
+// and processes that ask for an event during the simulation, e.g. for
+// wait(clk->posedge_event()). A process that calls wait_cycles() is taken
+// as one of the statically sensitive processes, like ::wait_cycles() does
+// for other clocks, and is a user only while it waits there. Without users
+// the clock stops after the current edge and restarts at the next rising
+// edge on enable(), on wait_cycles() or when an event is asked for again.
+// disable() gates the clock until enable(), regardless of users.
+//
+// The value is edge-only: value_changed_event() is the posedge event, so a
+// process that is sensitive to the value runs once per cycle, at the rising
+// edge. read() computes the level from the simulation time and falls at
+// half the period without any event.
+class gated_clock_if : public sc_signal_in_if<bool>
+{
+    public:
+    virtual const sc_time& period() const = 0;
+    virtual sc_time next_posedge() const = 0;
+    virtual void wait_cycles(unsigned int n) = 0;
+};
+
+class gated_clock : public sc_module, public gated_clock_if
+{
+    public:
+    SC_HAS_PROCESS(gated_clock);
+    gated_clock(const sc_module_name &name,
+                const sc_time &period,
+                bool enabled = true) :
+        sc_module(name),
+        clockPeriod(period),
+        enabled(enabled),
+        running(false),
+        started(false),
+        requested(false),
+        value(false),
+        staticUsers(0),
+        waiting(0),
+        edgeCount(0)
+    {
+        SC_METHOD(tick);
+        sensitive << posedgeEvent;
+    }
+
+    void enable()
+    {
+        if(!enabled)
+        {
+            enabled = true;
+            resume();
+        }
+    }
+
+    void disable()
+    {
+        enabled = false;
+        running = false;
+        posedgeEvent.cancel();
+    }
+
+    bool is_enabled() const
+    {
+        return enabled;
+    }
+
+    // False while the clock is gated, explicitly or for lack of users:
+    bool is_running() const
+    {
+        return running;
+    }
+
+    // Rising edges that were notified and that were gated so far:
+    sc_dt::uint64 edges() const
+    {
+        return edgeCount;
+    }
+
+    sc_dt::uint64 gated_edges() const
+    {
+        sc_dt::uint64 p = clockPeriod.value();
+        sc_dt::uint64 elapsed = (sc_time_stamp().value() + p - 1) / p;
+        return elapsed > edgeCount ? elapsed - edgeCount : 0;
+    }
+
+    const sc_time& period() const
+    {
+        return clockPeriod;
+    }
+
+    // Time of the next rising edge strictly after the current time. The
+    // rising edges are at 0, period, 2 * period, ...
+    sc_time next_posedge() const
+    {
+        sc_dt::uint64 p = clockPeriod.value();
+        sc_dt::uint64 now = sc_time_stamp().value();
+        return sc_time::from_value((now / p + 1) * p);
+    }
+
+    void wait_cycles(unsigned int n)
+    {
+        if(n == 0)
+        {
+            return;
+        }
+
+        sc_object *process = sc_get_current_process_handle().get_process_object();
+        if(cycleProcesses.insert(process).second && staticUsers > 0)
+        {
+            staticUsers--; // it skips the edges from now on
+        }
+
+        waiting++;
+        resume();
+        wait(next_posedge() - sc_time_stamp() + (n - 1) * clockPeriod);
+        waiting--;
+    }
+
+    // sc_signal_in_if<bool>:
+    const bool& read() const
+    {
+        sc_dt::uint64 p = clockPeriod.value();
+        value = sc_time_stamp().value() % p < p / 2;
+        return value;
+    }
+
+    const bool& get_data_ref() const
+    {
+        return read();
+    }
+
+    // Edge-only, see above:
+    const sc_event& value_changed_event() const
+    {
+        return posedge_event();
+    }
+
+    const sc_event& default_event() const
+    {
+        return posedge_event();
+    }
+
+    const sc_event& posedge_event() const
+    {
+        const_cast<gated_clock*>(this)->use();
+        return posedgeEvent;
+    }
+
+    const sc_event& negedge_event() const
+    {
+        return neverEvent;
+    }
+
+    bool event() const
+    {
+        return posedge();
+    }
+
+    bool posedge() const
+    {
+        return posedgeEvent.triggered();
+    }
+
+    bool negedge() const
+    {
+        return false;
+    }
+
+    virtual const char* kind() const
+    {
+        return "gated_clock";
+    }
+
+    private:
+    sc_time clockPeriod;
+    bool enabled;
+    bool running;   // a rising edge is notified
+    bool started;
+    bool requested; // an event was asked for during the simulation
+    mutable bool value;
+    unsigned int staticUsers;
+    unsigned int waiting;
+    sc_dt::uint64 edgeCount;
+    std::set<sc_object*> cycleProcesses;
+    sc_event posedgeEvent;
+    sc_event neverEvent;
+
+    void start_of_simulation()
+    {
+        started = true;
+    }
+
+    // Static sensitivity asks for the event during the elaboration, every
+    // later request is for the next edge:
+    void use()
+    {
+        if(!started)
+        {
+            staticUsers++;
+        }
+        else
+        {
+            requested = true;
+            resume();
+        }
+    }
+
+    // Restarts a gated clock at the next rising edge:
+    void resume()
+    {
+        if(enabled && started && !running)
+        {
+            running = true;
+            posedgeEvent.notify(next_posedge() - sc_time_stamp());
+        }
+    }
+
+    // Runs once at initialization for the edge at time 0 and then on every
+    // rising edge while the clock is running:
+    void tick()
+    {
+        running = false;
+        if(!enabled)
+        {
+            return;
+        }
+
+        if(sc_time_stamp() == SC_ZERO_TIME && !posedgeEvent.triggered())
+        {
+            running = true;
+            posedgeEvent.notify(SC_ZERO_TIME);
+            return;
+        }
+
+        edgeCount++;
+        if(staticUsers > 0 || waiting > 0 || requested)
+        {
+            running = true;
+            posedgeEvent.notify(clockPeriod);
+        }
+        requested = false;
+    }
+};
+
+// Waits for the n-th next rising edge of the clock that is bound to clk. A
+// gated_clock skips the cycles with a single timed wait, for any other
+// clock the process waits for n activations of its static sensitivity.
+inline void wait_cycles(sc_in<bool> &clk, unsigned int n = 1)
+{
+    gated_clock_if *g = dynamic_cast<gated_clock_if*>(clk.get_interface());
+    if(g)
+    {
+        g->wait_cycles(n);
+    }
+    else
+    {
+        for(unsigned int i = 0; i < n; i++)
+        {
+            wait();
+        }
+    }
+}
+
+#endif // GATED_CLOCK_H
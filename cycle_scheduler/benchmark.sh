@@ -0,0 +1,11 @@
+#!/usr/bin/env sh
+# Clocked SC_THREADs vs. cycle_scheduler callbacks for a growing number of
+# processes in three clock domains.
+# Usage: ./benchmark.sh <path to cycle_scheduler binary>
+BIN=${1:-./cycle_scheduler}
+
+for n in 10 100 1000
+do
+    $BIN threads $n 100000
+    $BIN scheduler $n 100000
+done
@@ -0,0 +1,234 @@
+/*
+ * Copyright 2017 Matthias Jung
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CYCLE_SCHEDULER_H
+#define CYCLE_SCHEDULER_H
+
+#include <systemc.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+class cycle_reg_base;
+
+// Group of cycle-based processes that share one clock. The processes are
+// plain callbacks, which are called one after the other on every rising
+// edge of the domain, without a coroutine switch per process.
+class clock_domain
+{
+    public:
+    clock_domain(const std::string &name, const sc_time &period) :
+        name(name),
+        period(period),
+        next(SC_ZERO_TIME),
+        cycles(0)
+    {
+    }
+
+    void add(const std::function<void()> &process)
+    {
+        processes.push_back(process);
+    }
+
+    const std::string name;
+    const sc_time period;
+
+    private:
+    friend struct cycle_scheduler;
+    friend class cycle_reg_base;
+
+    sc_time next;
+    unsigned long long cycles;
+    std::vector<std::function<void()> > processes;
+    std::vector<cycle_reg_base*> regs;
+};
+
+// Register with the semantics of a sc_signal written on a clock edge: all
+// processes of the edge read the old value, the written value becomes
+// visible after all processes of all domains with an edge at this time have
+// been called. A register is read by any domain, written by its own domain
+// only. SystemC processes outside the scheduler see the register through
+// value_changed_event(), which is only notified if it was requested, i.e.
+// the kernel is only involved at crossings into the event-driven world.
+class cycle_reg_base
+{
+    public:
+    cycle_reg_base(clock_domain &domain)
+    {
+        domain.regs.push_back(this);
+    }
+
+    virtual ~cycle_reg_base()
+    {
+    }
+
+    virtual void commit() = 0;
+};
+
+template <class T>
+class cycle_reg : public cycle_reg_base
+{
+    public:
+    cycle_reg(clock_domain &domain, const T &value = T()) :
+        cycle_reg_base(domain),
+        current(value),
+        next(value),
+        observed(false)
+    {
+    }
+
+    const T& read() const
+    {
+        return current;
+    }
+
+    void write(const T &value)
+    {
+        next = value;
+    }
+
+    const sc_event& value_changed_event()
+    {
+        observed = true;
+        return changed;
+    }
+
+    void commit()
+    {
+        if(!(current == next))
+        {
+            current = next;
+            if(observed)
+            {
+                changed.notify(SC_ZERO_TIME);
+            }
+        }
+    }
+
+    private:
+    T current;
+    T next;
+    bool observed;
+    sc_event changed;
+};
+
+// Calls the processes of all clock domains in a tight loop per edge. The
+// kernel resumes only the scheduler thread, once per distinct edge time of
+// all domains, instead of every clocked SC_THREAD on every clock edge. The
+// first edge of every domain is at time 0 like the first posedge of an
+// sc_clock.
+SC_MODULE(cycle_scheduler)
+{
+    public:
+    SC_CTOR(cycle_scheduler)
+    {
+        SC_THREAD(run);
+    }
+
+    ~cycle_scheduler()
+    {
+        for(clock_domain *d : domains)
+        {
+            delete d;
+        }
+    }
+
+    clock_domain& add_domain(const std::string &name, const sc_time &period)
+    {
+        domains.push_back(new clock_domain(name, period));
+        return *domains.back();
+    }
+
+    void report(std::ostream &os = std::cout) const
+    {
+        for(const clock_domain *d : domains)
+        {
+            os << "    domain " << d->name << " (" << d->period << "): "
+               << d->processes.size() << " processes, "
+               << d->cycles << " cycles" << std::endl;
+        }
+    }
+
+    private:
+    std::vector<clock_domain*> domains;
+    std::vector<clock_domain*> active;
+
+    void run()
+    {
+        if(domains.empty())
+        {
+            return;
+        }
+
+        while(true)
+        {
+            sc_time edge = domains[0]->next;
+            for(const clock_domain *d : domains)
+            {
+                if(d->next < edge)
+                {
+                    edge = d->next;
+                }
+            }
+
+            if(edge > sc_time_stamp())
+            {
+                wait(edge - sc_time_stamp());
+            }
+
+            active.clear();
+            for(clock_domain *d : domains)
+            {
+                if(d->next == edge)
+                {
+                    for(std::function<void()> &process : d->processes)
+                    {
+                        process();
+                    }
+                    d->cycles++;
+                    d->next += d->period;
+                    active.push_back(d);
+                }
+            }
+
+            // Update phase of the domains with an edge at this time:
+            for(clock_domain *d : active)
+            {
+                for(cycle_reg_base *r : d->regs)
+                {
+                    r->commit();
+                }
+            }
+        }
+    }
+};
+
+#endif // CYCLE_SCHEDULER_H
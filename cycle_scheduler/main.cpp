@@ -0,0 +1,196 @@
+/*
+ * Copyright 2017 Matthias Jung
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <systemc.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cycle_scheduler.h"
+
+// Next state of every process: a counter that also depends on the register
+// of its neighbour, which is usually in another clock domain.
+inline unsigned int step(unsigned int own, unsigned int neighbour)
+{
+    return own + 1 + (neighbour & 1);
+}
+
+// Clocked process as in mutex_example, resumed by the kernel on every edge:
+SC_MODULE(clocked_process)
+{
+    sc_in<bool> clk;
+    sc_in<unsigned int> neighbour;
+    sc_out<unsigned int> out;
+
+    SC_CTOR(clocked_process) : clk("clk"), neighbour("neighbour"), out("out")
+    {
+        SC_THREAD(process);
+        sensitive << clk.pos();
+        dont_initialize();
+    }
+
+    void process()
+    {
+        while(true)
+        {
+            out.write(step(out.read(), neighbour.read()));
+            wait();
+        }
+    }
+};
+
+// Event-driven SystemC process at the boundary of the cycle-based domains:
+SC_MODULE(observer)
+{
+    unsigned long long changes;
+
+    SC_HAS_PROCESS(observer);
+    observer(const sc_module_name &name, const sc_event &event) :
+        sc_module(name),
+        changes(0)
+    {
+        SC_METHOD(process);
+        sensitive << event;
+        dont_initialize();
+    }
+
+    void process()
+    {
+        changes++;
+    }
+};
+
+int sc_main(int argc, char *argv[])
+{
+    // Usage: cycle_scheduler [threads|scheduler] [processes] [cycles]
+    //
+    // The processes are distributed over three clock domains with 1 ns,
+    // 2 ns and 5 ns. Both variants compute the same registers, i.e. the
+    // same checksum.
+    std::string mode = argc > 1 ? argv[1] : "scheduler";
+    unsigned int n = argc > 2 ? atoi(argv[2]) : 100;
+    unsigned int cycles = argc > 3 ? atoi(argv[3]) : 100000;
+
+    if(n == 0 || (mode != "threads" && mode != "scheduler"))
+    {
+        std::cerr << "Usage: " << argv[0]
+                  << " [threads|scheduler] [processes] [cycles]" << std::endl;
+        return 1;
+    }
+
+    const sc_time periods[] = {sc_time(1, SC_NS),
+                               sc_time(2, SC_NS),
+                               sc_time(5, SC_NS)};
+
+    std::vector<sc_clock*> clocks;
+    std::vector<clocked_process*> processes;
+    std::vector<sc_signal<unsigned int>*> signals;
+
+    cycle_scheduler *scheduler = nullptr;
+    std::vector<cycle_reg<unsigned int>*> regs;
+
+    observer *o;
+
+    if(mode == "threads")
+    {
+        for(unsigned int d = 0; d < 3; d++)
+        {
+            std::string name = "clk" + std::to_string(d);
+            clocks.push_back(new sc_clock(name.c_str(), periods[d]));
+        }
+        for(unsigned int i = 0; i < n; i++)
+        {
+            std::string name = "process" + std::to_string(i);
+            processes.push_back(new clocked_process(name.c_str()));
+            signals.push_back(new sc_signal<unsigned int>());
+        }
+        for(unsigned int i = 0; i < n; i++)
+        {
+            processes[i]->clk(*clocks[i % 3]);
+            processes[i]->neighbour(*signals[(i + 1) % n]);
+            processes[i]->out(*signals[i]);
+        }
+        o = new observer("observer", signals[0]->value_changed_event());
+    }
+    else
+    {
+        scheduler = new cycle_scheduler("scheduler");
+
+        std::vector<clock_domain*> domains;
+        for(unsigned int d = 0; d < 3; d++)
+        {
+            std::string name = "clk" + std::to_string(d);
+            domains.push_back(&scheduler->add_domain(name, periods[d]));
+        }
+        for(unsigned int i = 0; i < n; i++)
+        {
+            regs.push_back(new cycle_reg<unsigned int>(*domains[i % 3]));
+        }
+        for(unsigned int i = 0; i < n; i++)
+        {
+            cycle_reg<unsigned int> *own = regs[i];
+            cycle_reg<unsigned int> *neighbour = regs[(i + 1) % n];
+
+            domains[i % 3]->add([own, neighbour]()
+            {
+                own->write(step(own->read(), neighbour->read()));
+            });
+        }
+        o = new observer("observer", regs[0]->value_changed_event());
+    }
+
+    // All edges are on full nanoseconds:
+    auto start = std::chrono::steady_clock::now();
+    sc_start(sc_time(cycles, SC_NS) - sc_time(0.5, SC_NS));
+    auto end = std::chrono::steady_clock::now();
+    double time = std::chrono::duration<double>(end - start).count();
+
+    unsigned long long checksum = 0;
+    for(unsigned int i = 0; i < n; i++)
+    {
+        checksum += mode == "threads" ? signals[i]->read() : regs[i]->read();
+    }
+
+    std::cout << mode << ": " << n << " processes, "
+              << cycles << " cycles of the 1 ns domain" << std::endl;
+    if(scheduler)
+    {
+        scheduler->report();
+    }
+    std::cout << "    host time:      " << time << " s" << std::endl
+              << "    checksum:       " << checksum << std::endl
+              << "    observed:       " << o->changes << " changes"
+              << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,189 @@
+/*
+ * Copyright 2017 Matthias Jung
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef DELTA_PROFILER_H
+#define DELTA_PROFILER_H
+
+#include <systemc.h>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <vector>
+
+// Records for every timestep the number of delta cycles, the activations
+// of the instrumented processes and the value changes of the instrumented
+// signals. A process is instrumented by calling activated() at the
+// beginning of its body, a signal by using profiled_signal instead of
+// sc_signal. If the number of delta cycles in one timestep exceeds the
+// threshold, the loop is reported as non-converging together with the
+// processes and signals involved, and the simulation is stopped if
+// stopOnStorm is set.
+SC_MODULE(delta_profiler)
+{
+    public:
+    struct timestep
+    {
+        sc_time time;
+        sc_dt::uint64 firstDelta;
+        sc_dt::uint64 lastDelta;
+        std::map<const sc_object*, unsigned long> processes;
+        std::map<const sc_object*, unsigned long> signals;
+
+        sc_dt::uint64 deltas() const
+        {
+            return lastDelta - firstDelta + 1;
+        }
+    };
+
+    delta_profiler(const sc_module_name &name,
+                   sc_dt::uint64 threshold = 1000,
+                   bool stopOnStorm = true) :
+        sc_module(name),
+        threshold(threshold),
+        stopOnStorm(stopOnStorm),
+        reported(false)
+    {
+    }
+
+    void activated()
+    {
+        sc_process_handle p = sc_get_current_process_handle();
+        current().processes[p.get_process_object()]++;
+        check();
+    }
+
+    void changed(const sc_object *signal)
+    {
+        current().signals[signal]++;
+        check();
+    }
+
+    const std::vector<timestep>& timesteps() const
+    {
+        return steps;
+    }
+
+    void report(std::ostream &os = std::cout) const
+    {
+        os << std::endl << "Delta Cycle Profile:" << std::endl;
+        for(const timestep &t : steps)
+        {
+            print(os, t);
+        }
+    }
+
+    private:
+    sc_dt::uint64 threshold;
+    bool stopOnStorm;
+    bool reported;
+    std::vector<timestep> steps;
+
+    timestep& current()
+    {
+        if(steps.empty() || steps.back().time != sc_time_stamp())
+        {
+            timestep t;
+            t.time = sc_time_stamp();
+            t.firstDelta = sc_delta_count();
+            steps.push_back(t);
+            reported = false;
+        }
+        steps.back().lastDelta = sc_delta_count();
+        return steps.back();
+    }
+
+    void check()
+    {
+        const timestep &t = steps.back();
+
+        if(t.deltas() > threshold && !reported)
+        {
+            reported = true;
+            std::ostringstream msg;
+            msg << "No convergence after " << t.deltas()
+                << " delta cycles @" << t.time;
+            SC_REPORT_WARNING(name(), msg.str().c_str());
+            print(std::cout, t);
+
+            if(stopOnStorm)
+            {
+                sc_stop();
+            }
+        }
+    }
+
+    static void print(std::ostream &os, const timestep &t)
+    {
+        os << "@" << t.time << ": " << t.deltas() << " δ" << std::endl;
+        for(auto &p : t.processes)
+        {
+            os << "    process " << std::setw(24) << std::left
+               << p.first->name() << std::right << p.second
+               << " activations" << std::endl;
+        }
+        for(auto &s : t.signals)
+        {
+            os << "    signal  " << std::setw(24) << std::left
+               << s.first->name() << std::right << s.second
+               << " changes" << std::endl;
+        }
+    }
+};
+
+// sc_signal that reports its value changes to a delta_profiler
+template <class T>
+class profiled_signal : public sc_signal<T>
+{
+    public:
+    profiled_signal(const char *name, delta_profiler &profiler) :
+        sc_signal<T>(name),
+        profiler(profiler)
+    {
+    }
+
+    using sc_signal<T>::operator=;
+
+    protected:
+    virtual void update()
+    {
+        T old = this->read();
+        sc_signal<T>::update();
+        if(!(old == this->read()))
+        {
+            profiler.changed(this);
+        }
+    }
+
+    private:
+    delta_profiler &profiler;
+};
+
+#endif // DELTA_PROFILER_H
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2017 Matthias Jung
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <systemc.h>
+#include "delta_profiler.h"
+
+// The rslatch of feedback_loop, instrumented with the delta profiler
+SC_MODULE(rslatch)
+{
+    sc_in<bool> S;
+    sc_in<bool> R;
+    sc_out<bool> Q;
+    sc_out<bool> N;
+
+    delta_profiler &profiler;
+
+    SC_HAS_PROCESS(rslatch);
+    rslatch(const sc_module_name &name, delta_profiler &profiler) :
+        sc_module(name), S("S"), R("R"), Q("Q"), N("N"), profiler(profiler)
+    {
+        SC_METHOD(process);
+        sensitive << S << R << Q << N;
+    }
+
+    void process()
+    {
+        profiler.activated();
+        Q.write(!(R.read()||N.read())); // Nor Gate
+        N.write(!(S.read()||Q.read())); // Nor Gate
+    }
+};
+
+SC_MODULE(toplevel)
+{
+    delta_profiler profiler;
+
+    profiled_signal<bool> Ssig;
+    profiled_signal<bool> Rsig;
+    profiled_signal<bool> Qsig;
+    profiled_signal<bool> Nsig;
+
+    rslatch rs;
+
+    SC_CTOR(toplevel) : profiler("profiler", 100 /* δ threshold */),
+                        Ssig("S", profiler),
+                        Rsig("R", profiler),
+                        Qsig("Q", profiler),
+                        Nsig("N", profiler),
+                        rs("rs", profiler)
+    {
+        SC_THREAD(process);
+
+        rs.S(Ssig);
+        rs.R(Rsig);
+        rs.Q(Qsig);
+        rs.N(Nsig);
+    }
+
+    void process()
+    {
+        profiler.activated();
+
+        // Set: converges after a few delta cycles
+        Ssig.write(true);
+        Rsig.write(false);
+        wait(10, SC_NS);
+
+        // Hold:
+        Ssig.write(false);
+        wait(10, SC_NS);
+
+        // Forbidden state S=R=1, i.e. Q=N=0:
+        Ssig.write(true);
+        Rsig.write(true);
+        wait(10, SC_NS);
+
+        // Releasing S and R at the same time lets the latch oscillate
+        // forever (see feedback_loop), the profiler stops the simulation:
+        Ssig.write(false);
+        Rsig.write(false);
+        wait(10, SC_NS);
+
+        sc_stop();
+    }
+};
+
+int sc_main (int __attribute__((unused)) sc_argc,
+             char __attribute__((unused)) *sc_argv[])
+{
+    toplevel t("t");
+
+    sc_set_stop_mode(SC_STOP_FINISH_DELTA);
+    sc_start();
+
+    t.profiler.report();
+
+    return 0;
+}
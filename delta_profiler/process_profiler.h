@@ -0,0 +1,348 @@
+/*
+ * Copyright 2017 Matthias Jung
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PROCESS_PROFILER_H
+#define PROCESS_PROFILER_H
+
+#include <systemc.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Opt-in profiler for the host time of the SystemC processes. It is active
+// only if a process_profiler module has been instantiated, otherwise all
+// hooks are no-ops. The processes mark where they run:
+//
+//   SC_METHOD:  process_profiler::activation a;   at the top of the body
+//   SC_THREAD:  process_profiler::enter();        at the top of the body
+//               profiled_wait(...);               instead of wait(...)
+//               profiled_fifo<T>                  instead of sc_fifo<T>
+//
+// Host time between two hooks of the same running process is attributed to
+// the process, all other host time (scheduler, channel updates, code of
+// processes that are not instrumented) to [kernel]. If a process is
+// suspended without a hook, e.g. in a blocking sc_fifo read, this is
+// detected at the next hook of another process and counted as context
+// switch. At end_of_simulation a table is printed and a folded stack file
+// is written, which can be rendered with flamegraph.pl.
+SC_MODULE(process_profiler)
+{
+    public:
+    struct record
+    {
+        std::string name;
+        unsigned long long activations;
+        unsigned long long switches;
+        unsigned long long ns;
+    };
+
+    class activation
+    {
+        public:
+        activation()
+        {
+            enter();
+        }
+
+        ~activation()
+        {
+            leave(false);
+        }
+    };
+
+    process_profiler(const sc_module_name &name,
+                     const std::string &file = "profile.folded") :
+        sc_module(name),
+        file(file),
+        last(nullptr),
+        running(false),
+        kernel(0)
+    {
+        instance() = this;
+    }
+
+    ~process_profiler()
+    {
+        instance() = nullptr;
+    }
+
+    // The current process starts or resumes its execution
+    static void enter()
+    {
+        if(process_profiler *p = instance())
+        {
+            p->hook(true, false);
+        }
+    }
+
+    // The current process stops, suspend is true for a context switch
+    static void leave(bool suspend)
+    {
+        if(process_profiler *p = instance())
+        {
+            p->hook(false, suspend);
+        }
+    }
+
+    // A profiler has been instantiated, e.g. to skip delays for a viewer:
+    static bool active()
+    {
+        return instance() != nullptr;
+    }
+
+    void report(std::ostream &os = std::cout) const
+    {
+        std::vector<const record*> sorted;
+        unsigned long long total = kernel;
+        for(auto &r : records)
+        {
+            sorted.push_back(&r.second);
+            total += r.second.ns;
+        }
+        std::sort(sorted.begin(), sorted.end(),
+                  [](const record *a, const record *b)
+                  {
+                      return a->ns > b->ns;
+                  });
+
+        os << std::endl << "Process Profile:" << std::endl
+           << std::left << std::setw(32) << "process" << std::right
+           << std::setw(14) << "activations"
+           << std::setw(14) << "switches"
+           << std::setw(14) << "host ms"
+           << std::setw(8) << "%" << std::endl;
+
+        for(const record *r : sorted)
+        {
+            print(os, r->name, r->activations, r->switches, r->ns, total);
+        }
+        print(os, "[kernel]", 0, 0, kernel, total);
+    }
+
+    private:
+    std::string file;
+    std::map<const sc_object*, record> records;
+    const sc_object *last;
+    bool running;
+    unsigned long long kernel;
+    std::chrono::steady_clock::time_point lastTime;
+
+    static process_profiler*& instance()
+    {
+        static process_profiler *p = nullptr;
+        return p;
+    }
+
+    record& get(const sc_object *process)
+    {
+        record &r = records[process];
+        if(r.name.empty())
+        {
+            r.name = process->name();
+        }
+        return r;
+    }
+
+    void hook(bool start, bool suspend)
+    {
+        const sc_object *process =
+            sc_get_current_process_handle().get_process_object();
+        if(process == nullptr)
+        {
+            return;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        unsigned long long ns = std::chrono::duration_cast<
+            std::chrono::nanoseconds>(now - lastTime).count();
+        lastTime = now;
+
+        if(running && last == process)
+        {
+            get(process).ns += ns;
+        }
+        else
+        {
+            kernel += ns;
+            if(running && last != nullptr)
+            {
+                // The last process was suspended without a hook:
+                get(last).switches++;
+            }
+        }
+
+        record &r = get(process);
+        if(start)
+        {
+            r.activations++;
+        }
+        else if(suspend)
+        {
+            r.switches++;
+        }
+
+        running = start;
+        last = process;
+    }
+
+    // Collect all processes of the hierarchy, so that processes without
+    // instrumentation show up in the report as well:
+    void collect(const std::vector<sc_object*> &objects)
+    {
+        for(sc_object *o : objects)
+        {
+            std::string kind = o->kind();
+            if(kind == "sc_method_process" || kind == "sc_thread_process"
+               || kind == "sc_cthread_process")
+            {
+                get(o);
+            }
+            collect(o->get_child_objects());
+        }
+    }
+
+    void start_of_simulation()
+    {
+        collect(sc_get_top_level_objects());
+        lastTime = std::chrono::steady_clock::now();
+    }
+
+    void end_of_simulation()
+    {
+        auto now = std::chrono::steady_clock::now();
+        kernel += std::chrono::duration_cast<
+            std::chrono::nanoseconds>(now - lastTime).count();
+        running = false;
+
+        report();
+
+        // Folded stacks: one line per process, the module hierarchy is the
+        // stack, the host time in ns the weight.
+        std::ofstream out(file);
+        for(auto &r : records)
+        {
+            if(r.second.ns == 0)
+            {
+                continue;
+            }
+            std::string stack = r.second.name;
+            std::replace(stack.begin(), stack.end(), '.', ';');
+            out << stack << " " << r.second.ns << std::endl;
+        }
+        out << "[kernel] " << kernel << std::endl;
+
+        std::cout << "Folded stacks written to " << file
+                  << " (flamegraph.pl " << file << " > profile.svg)"
+                  << std::endl;
+    }
+
+    static void print(std::ostream &os,
+                      const std::string &name,
+                      unsigned long long activations,
+                      unsigned long long switches,
+                      unsigned long long ns,
+                      unsigned long long total)
+    {
+        os << std::left << std::setw(32) << name << std::right
+           << std::setw(14) << activations
+           << std::setw(14) << switches
+           << std::setw(14) << std::fixed << std::setprecision(3)
+           << ns / 1e6
+           << std::setw(8) << std::setprecision(1)
+           << (total ? 100.0 * ns / total : 0.0)
+           << std::defaultfloat << std::endl;
+    }
+};
+
+// wait() of an SC_THREAD that is profiled by the process_profiler
+template <class... Args>
+inline void profiled_wait(Args&&... args)
+{
+    process_profiler::leave(true);
+    sc_core::wait(std::forward<Args>(args)...);
+    process_profiler::enter();
+}
+
+// sc_fifo whose blocking read and write hook a suspension of the calling
+// SC_THREAD, so the thread keeps the plain fifo calls. Non-blocking calls
+// and calls that find data or space cost one comparison.
+template <class T>
+class profiled_fifo : public sc_core::sc_fifo<T>
+{
+    public:
+    explicit profiled_fifo(int size = 16) : sc_core::sc_fifo<T>(size)
+    {
+    }
+
+    profiled_fifo(const char *name, int size = 16) :
+        sc_core::sc_fifo<T>(name, size)
+    {
+    }
+
+    using sc_core::sc_fifo<T>::read;
+    using sc_core::sc_fifo<T>::write;
+
+    void read(T &value) override
+    {
+        bool block = this->num_available() == 0;
+        if(block)
+        {
+            process_profiler::leave(true);
+        }
+        sc_core::sc_fifo<T>::read(value);
+        if(block)
+        {
+            process_profiler::enter();
+        }
+    }
+
+    void write(const T &value) override
+    {
+        bool block = this->num_free() == 0;
+        if(block)
+        {
+            process_profiler::leave(true);
+        }
+        sc_core::sc_fifo<T>::write(value);
+        if(block)
+        {
+            process_profiler::enter();
+        }
+    }
+};
+
+#endif // PROCESS_PROFILER_H
@@ -32,6 +32,8 @@
  */
 
 #include <systemc.h>
+#include <cstring>
+#include <fstream>
 #include <unistd.h>
 
 SC_MODULE(rslatch)
@@ -65,7 +67,21 @@ SC_MODULE(toplevel)
     sc_time currentTime;
     unsigned long long currentDelta;
 
-    SC_CTOR(toplevel) : rs("rs")
+    // By default the oscillation is shown at human speed and forever. With
+    // steps > 0 the given number of delta cycles is recorded at full
+    // simulation speed. Replay it with: ./replay.pl feedback_loop.trace
+    // or analyze it with: ./replay.pl --analyze feedback_loop.trace
+    std::ostream &out;
+    unsigned int steps;
+
+    SC_HAS_PROCESS(toplevel);
+    toplevel(const sc_module_name &name,
+             std::ostream &out = std::cout,
+             unsigned int steps = 0) :
+        sc_module(name),
+        rs("rs"),
+        out(out),
+        steps(steps)
     {
         SC_THREAD(process);
 
@@ -74,7 +90,7 @@ SC_MODULE(toplevel)
         rs.Q(Qsig);
         rs.N(Nsig);
 
-        std::cout << "\nS=0, R=0, Q=0, N=0\n" << std::endl;
+        out << "\nS=0, R=0, Q=0, N=0\n" << std::endl;
         Ssig.write(false);
         Rsig.write(false);
         Qsig.write(false);
@@ -100,34 +116,59 @@ SC_MODULE(toplevel)
 
         unsigned long long delta = sc_delta_count() - currentDelta;
 
-        std::cout << time <<" + " << delta << "δ\t"
-                  << Ssig.read() << "\t"
-                  << Rsig.read() << "\t"
-                  << Qsig.read() << "\t"
-                  << Nsig.read() << "\t" << std::endl;
+        out << time <<" + " << delta << "δ\t"
+            << Ssig.read() << "\t"
+            << Rsig.read() << "\t"
+            << Qsig.read() << "\t"
+            << Nsig.read() << "\t" << std::endl;
     }
 
     void process()
     {
         // Start in Reset State
 
-        while(true)
+        if(steps == 0)
         {
-            usleep(100000);
-            waitAndPrint(SC_ZERO_TIME);
-        }
+            while(true)
+            {
+                usleep(100000);
+                waitAndPrint(SC_ZERO_TIME);
+            }
 
-        wait();
+            wait();
+
+            // Simulation will hang and never stop!
+        }
 
-        // Simulation will hang and never stop!
+        for(unsigned int i = 0; i < steps; i++)
+        {
+            waitAndPrint(SC_ZERO_TIME);
+        }
 
         sc_stop();
     }
 };
 
-int sc_main (int __attribute__((unused)) sc_argc,
-             char __attribute__((unused)) *sc_argv[])
+int sc_main (int sc_argc, char *sc_argv[])
 {
+    // Usage: feedback_loop [record [<delta cycles> [<trace file>]]]
+    if(sc_argc > 1 && strcmp(sc_argv[1], "record") == 0)
+    {
+        unsigned int steps = sc_argc > 2 ? atoi(sc_argv[2]) : 1000;
+        const char *file = sc_argc > 3 ? sc_argv[3] : "feedback_loop.trace";
+        std::ofstream trace(file);
+
+        trace << "\nT\t\tS\tR\tQ\tN" << std::endl;
+        toplevel t("t", trace, steps);
+
+        sc_set_stop_mode(SC_STOP_FINISH_DELTA);
+        sc_start();
+
+        std::cout << "Recorded " << steps << " delta cycles in "
+                  << file << std::endl;
+        return 0;
+    }
+
     std::cout << "\nT\t\tS\tR\tQ\tN" << std::endl;
     toplevel t("t");
 
@@ -0,0 +1,136 @@
+#!/usr/bin/perl -w
+#
+# Copyright 2017 Matthias Jung
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# 1. Redistributions of source code must retain the above copyright notice,
+#    this list of conditions and the following disclaimer.
+#
+# 2. Redistributions in binary form must reproduce the above copyright notice,
+#    this list of conditions and the following disclaimer in the documentation
+#    and/or other materials provided with the distribution.
+#
+# 3. Neither the name of the copyright holder nor the names of its contributors
+#    may be used to endorse or promote products derived from this software
+#    without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+# AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+# THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+# OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+# WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+# OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+# ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+# Authors:
+#     - Matthias Jung
+
+use warnings;
+use strict;
+use Time::HiRes qw(sleep);
+
+# Offline viewer for the traces recorded by feedback_loop and
+# kpn_artificial_deadlock with their record argument. The models then run
+# at full speed and write their state into a trace file, this script
+# replays it at human speed:
+#
+#   replay.pl [--analyze] <trace> [delay in s]
+#
+# Traces that contain form feed lines are replayed frame by frame (the
+# screen is cleared before each frame), all other traces line by line.
+# With --analyze the S/R/Q/N states of a feedback_loop trace are checked
+# for convergence or for the period of the oscillation.
+
+my $analyze = 0;
+if(@ARGV && $ARGV[0] eq "--analyze")
+{
+    $analyze = 1;
+    shift @ARGV;
+}
+
+die "Usage: replay.pl [--analyze] <trace> [delay in s]\n" if(@ARGV < 1);
+
+my $file = $ARGV[0];
+my $delay = defined($ARGV[1]) ? $ARGV[1] : 0.1;
+
+open(my $fh, "<", $file) or die "Cannot open $file: $!\n";
+my @lines = <$fh>;
+close($fh);
+
+if($analyze)
+{
+    analyze(@lines);
+}
+elsif(grep { /^\f$/ } @lines)
+{
+    my @frames = split(/^\f\n/m, join("", @lines));
+    foreach my $frame (@frames)
+    {
+        next if($frame eq "");
+        print "\033[2J\033[H";
+        print $frame;
+        sleep($delay);
+    }
+}
+else
+{
+    $| = 1;
+    foreach my $line (@lines)
+    {
+        print $line;
+        sleep($delay) if($line =~ /δ/);
+    }
+}
+
+sub analyze
+{
+    my @states;
+    foreach my $line (@_)
+    {
+        # e.g. "0 s + 3δ	1	1	0	0	"
+        if($line =~ /\+\s*(\d+)\S*\s+(\d)\s+(\d)\s+(\d)\s+(\d)/)
+        {
+            push(@states, "$2$3$4$5");
+        }
+    }
+
+    die "No states found in trace\n" if(@states == 0);
+
+    # Search the shortest period p for which the tail of the trace repeats:
+    my $n = scalar(@states);
+    my $tail = int($n / 2);
+    for(my $p = 1; $p <= $tail; $p++)
+    {
+        my $periodic = 1;
+        for(my $i = $n - $tail; $i < $n - $p; $i++)
+        {
+            if($states[$i] ne $states[$i + $p])
+            {
+                $periodic = 0;
+                last;
+            }
+        }
+        if($periodic)
+        {
+            if($p == 1)
+            {
+                print "Converged to S R Q N = $states[-1]"
+                    . " after at most " . ($n - $tail) . " delta cycles\n";
+            }
+            else
+            {
+                my @cycle = @states[$n - $p .. $n - 1];
+                print "Oscillation with a period of $p delta cycles: "
+                    . join(" -> ", @cycle) . "\n";
+            }
+            return;
+        }
+    }
+    print "No period found in $n delta cycles\n";
+}
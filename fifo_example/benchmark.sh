@@ -0,0 +1,8 @@
+#!/usr/bin/env sh
+# Host time of the producer/consumer example with sc_clock and gated_clock.
+# Usage: ./benchmark.sh <path to fifo_example binary> [cycles]
+BIN=${1:-./fifo_example}
+CYCLES=${2:-10000000}
+
+$BIN sc_clock $CYCLES
+$BIN gated $CYCLES
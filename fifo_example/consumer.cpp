@@ -40,8 +40,11 @@ void consumer::process()
     {
         // Blocking read, i.e. an implicit wait is called
         unsigned int value = fifo_port->read();
-        std::cout << "@" << sc_time_stamp()
-                  << " CONSUMER: Consumed " << value << std::endl;
-        wait(); // Wait for next clock
+        if(verbose)
+        {
+            std::cout << "@" << sc_time_stamp()
+                      << " CONSUMER: Consumed " << value << std::endl;
+        }
+        wait_cycles(clk); // Wait for next clock
     }
 }
@@ -36,6 +36,7 @@
 
 #include <systemc.h>
 #include <iostream>
+#include "../clock_generator/gated_clock.h"
 
 
 SC_MODULE(consumer)
@@ -45,8 +46,9 @@ SC_MODULE(consumer)
     sc_in<bool> clk;
     // Thats the short way of writing it:
     sc_fifo_in<unsigned int> fifo_port;
+    bool verbose;
 
-    SC_CTOR(consumer) : clk("clk"), fifo_port("fifo_in")
+    SC_CTOR(consumer) : clk("clk"), fifo_port("fifo_in"), verbose(true)
     {
         SC_THREAD(process);
         dont_initialize();
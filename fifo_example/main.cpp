@@ -32,13 +32,80 @@
  */
 
 #include <systemc.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include "producer.h"
 #include "consumer.h"
 
-int sc_main(int __attribute__((unused)) argc,
-            char __attribute__((unused)) *argv[])
+// Runs the producer and consumer for the given number of clk1 cycles without
+// output, either with two sc_clocks or with two gated_clocks. Both kinds of
+// clocks stay enabled for the whole run. The gated_clocks notify one event
+// per cycle instead of two and gate themselves only while no process uses
+// them, these gated edges are reported separately.
+int benchmark(bool gated, unsigned long long cycles)
 {
+    sc_clock *clk1 = nullptr, *clk2 = nullptr;
+    gated_clock *gclk1 = nullptr, *gclk2 = nullptr;
+
+    producer p("producer");
+    consumer c("consumer");
+    sc_fifo<unsigned int> channel(4);
+
+    p.limit = 0;
+    p.verbose = false;
+    c.verbose = false;
+    p.fifo_port.bind(channel);
+    c.fifo_port.bind(channel);
+
+    if(gated)
+    {
+        gclk1 = new gated_clock("clk1", sc_time(1, SC_NS));
+        gclk2 = new gated_clock("clk2", sc_time(2, SC_NS));
+        p.clk(*gclk1);
+        c.clk(*gclk2);
+    }
+    else
+    {
+        clk1 = new sc_clock("clk1", 1, SC_NS, 0.5, 0, SC_NS, true);
+        clk2 = new sc_clock("clk2", 2, SC_NS, 0.5, 0, SC_NS, true);
+        p.clk(*clk1);
+        c.clk(*clk2);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    sc_start(sc_time(cycles, SC_NS));
+    auto end = std::chrono::steady_clock::now();
+    double time = std::chrono::duration<double>(end - start).count();
+
+    std::cout << (gated ? "gated_clock" : "sc_clock") << ": "
+              << cycles << " cycles, "
+              << p.counter - 1 << " values produced" << std::endl
+              << "    host time:      " << time << " s" << std::endl
+              << "    cycles/s:       " << cycles / time << std::endl;
+
+    if(gated)
+    {
+        std::cout << "    edges notified: "
+                  << gclk1->edges() + gclk2->edges() << std::endl
+                  << "    edges gated:    "
+                  << gclk1->gated_edges() + gclk2->gated_edges() << std::endl;
+    }
+
+    return 0;
+}
+
+int sc_main(int argc, char *argv[])
+{
+    // Usage: fifo_example [sc_clock|gated] [cycles]
+    if(argc > 1)
+    {
+        bool gated = strcmp(argv[1], "gated") == 0;
+        unsigned long long cycles = argc > 2 ? atoll(argv[2]) : 10000000;
+        return benchmark(gated, cycles);
+    }
+
     // Setup Clocks
     sc_clock clk1("clk1", 1, SC_NS, 0.5, 0, SC_NS, true);
     sc_clock clk2("clk2", 2, SC_NS, 0.5, 0, SC_NS, true);
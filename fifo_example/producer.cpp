@@ -41,13 +41,16 @@ void producer::process()
         unsigned int value = counter++;
 
         fifo_port->write(value);
-        std::cout << "@" << sc_time_stamp()
-                  << " PRODUCER: Produced " << value << std::endl;
+        if(verbose)
+        {
+            std::cout << "@" << sc_time_stamp()
+                      << " PRODUCER: Produced " << value << std::endl;
+        }
 
-        if(counter == 20)
+        if(counter == limit)
         {
             sc_stop();
         }
-        wait(); // wait for next clock
+        wait_cycles(clk); // wait for next clock
     }
 }
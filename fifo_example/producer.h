@@ -36,6 +36,7 @@
 
 #include <systemc.h>
 #include <iostream>
+#include "../clock_generator/gated_clock.h"
 
 
 SC_MODULE(producer)
@@ -46,8 +47,11 @@ SC_MODULE(producer)
     // Thats the long way of writing it:
     sc_port< sc_fifo_out_if< unsigned int > > fifo_port;
     unsigned int counter;
+    unsigned int limit;   // Stop the simulation after limit values, 0: never
+    bool verbose;
 
-    SC_CTOR(producer) : counter(1), clk("clk"), fifo_port("fifo_out")
+    SC_CTOR(producer) : counter(1), limit(20), verbose(true),
+                        clk("clk"), fifo_port("fifo_out")
     {
         SC_THREAD(process);
         dont_initialize();
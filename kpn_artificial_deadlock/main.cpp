@@ -32,15 +32,24 @@
  */
 
 #include <systemc.h>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 #include "kpn.h"
 
 using namespace std;
 
-int sc_main(int __attribute__((unused)) argc,
-            char __attribute__((unused)) *argv[])
+int sc_main(int argc, char *argv[])
 
 {
+    // Usage: kpn_artificial_deadlock [record [<trace file>]]
+    std::ofstream trace;
+    if(argc > 1 && strcmp(argv[1], "record") == 0)
+    {
+        trace.open(argc > 2 ? argv[2] : "kpn.trace");
+        my_sc_fifo<unsigned int>::record(trace);
+    }
+
     kpn kahn("kpn");
     sc_start(1,SC_NS);
 
@@ -53,5 +62,11 @@ int sc_main(int __attribute__((unused)) argc,
         std::cout << "ARTIFICIAL DEADLOCK" << std::endl;
     }
 
+    if(trace.is_open())
+    {
+        std::cout << "FIFO states recorded in "
+                  << (argc > 2 ? argv[2] : "kpn.trace") << std::endl;
+    }
+
     return 0;
 }
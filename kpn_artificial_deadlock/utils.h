@@ -50,8 +50,18 @@ class my_sc_fifo : public sc_fifo<T>
         fifos.push_back(this);
     }
 
+    // Instead of showing the FIFO states at human speed, record them at
+    // full simulation speed into the stream, one frame per FIFO access.
+    // Replay them with: ../feedback_loop/replay.pl kpn.trace 0.05
+    static void record(std::ostream &os)
+    {
+        trace = &os;
+    }
+
   private:
 
+    static std::ostream *trace;
+
     static std::vector< my_sc_fifo<T>* > fifos;
 
     int get_size()
@@ -73,38 +83,50 @@ class my_sc_fifo : public sc_fifo<T>
     }
 
   public:
-    void print_fifo()
+    void print_fifo(std::ostream &os = std::cout)
     {
         int max = get_size();
         int n = get_number();
 
-        std::cout << this->name() << " (" << max << ") " << "[";
+        os << this->name() << " (" << max << ") " << "[";
         for(int i = 0; i < n; i++) {
-            std::cout << "█";
+            os << "█";
         }
         for(int i = 0; i < max-n; i++) {
-            std::cout << " ";
+            os << " ";
         }
-        std::cout << "]" << std::endl;
-        std::cout.flush();
+        os << "]" << std::endl;
+        os.flush();
     }
 
     static void print_fifos()
     {
-        system("clear");
-        std::cout << std::endl << "Kahn Process Network with SystemC" << std::endl;
-        std::cout << "Matthias Jung, Éder Zulian (2017)" << std::endl;
+        std::ostream &os = trace ? *trace : std::cout;
 
-        std::cout << std::endl << "δ: " << sc_delta_count() << std::endl;
+        if(trace)
+        {
+            os << "\f" << std::endl; // Frame separator for the replay
+        }
+        else
+        {
+            system("clear");
+        }
+        os << std::endl << "Kahn Process Network with SystemC" << std::endl;
+        os << "Matthias Jung, Éder Zulian (2017)" << std::endl;
+
+        os << std::endl << "δ: " << sc_delta_count() << std::endl;
 
         // Print all fifos:
         for(auto f : fifos)
         {
-            f->print_fifo();
+            f->print_fifo(os);
         }
 
-        usleep(50000);
-        //system("read");
+        if(!trace)
+        {
+            usleep(50000);
+            //system("read");
+        }
     }
 
     T read()
@@ -124,4 +146,7 @@ class my_sc_fifo : public sc_fifo<T>
 template <class T>
 std::vector< my_sc_fifo<T>* > my_sc_fifo<T>::fifos({});
 
+template <class T>
+std::ostream *my_sc_fifo<T>::trace = nullptr;
+
 #endif // UTILS_H
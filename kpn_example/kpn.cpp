@@ -1,8 +1,11 @@
 #include "kpn.h"
 #include <unistd.h>
+#include "../delta_profiler/process_profiler.h"
 
 void kpn::kpn_add() // consumes and produces
 {
+    // The fifos hook the suspensions of the blocking calls:
+    process_profiler::enter();
     while(true)
     {
         y.write(a.read() + b.read());
@@ -11,27 +14,30 @@ void kpn::kpn_add() // consumes and produces
 
 void kpn::kpn_a() // produces
 {
+    process_profiler::enter();
     while(true)
     {
-        wait(sc_time(10,SC_NS));
+        profiled_wait(sc_time(10,SC_NS));
         a.write(1);
     }
 }
 
 void kpn::kpn_b() // produces
 {
+    process_profiler::enter();
     while(true)
     {
-        wait(sc_time(1,SC_NS));
+        profiled_wait(sc_time(1,SC_NS));
         b.write(2);
     }
 }
 
 void kpn::kpn_y() // consumes
 {
+    process_profiler::enter();
     while(true)
     {
-        wait(sc_time(20,SC_NS));
+        profiled_wait(sc_time(20,SC_NS));
         double __attribute__((unused)) value = y.read();
     }
 }
@@ -40,6 +46,7 @@ void kpn::kpn_y() // consumes
 
 void kpn::debug_thread()
 {
+    process_profiler::enter();
     while(true)
     {
         system("clear");
@@ -51,13 +58,17 @@ void kpn::debug_thread()
         print_fifo(10,10-b.num_free(),"B");
         print_fifo(20,20-y.num_free(),"Y");
 
-        usleep(300000);
+        // Slows the animation down, but not a profiled run:
+        if(!process_profiler::active())
+        {
+            usleep(300000);
+        }
 
         if(y.num_free()==0)
         {
             sc_stop();
         }
-        wait();
+        profiled_wait();
     }
 }
 
@@ -36,12 +36,13 @@
 #define KPN_H
 
 #include <systemc.h>
+#include "../delta_profiler/process_profiler.h"
 
 
 SC_MODULE(kpn)
 {
   private:
-    sc_fifo<double> a, b, y;
+    profiled_fifo<double> a, b, y;
     void kpn_add();
     void kpn_a();
     void kpn_b();
@@ -1,12 +1,20 @@
 #include <systemc.h>
+#include <cstring>
 #include <iostream>
 #include "kpn.h"
+#include "../delta_profiler/process_profiler.h"
 
 using namespace std;
 
-int sc_main(int __attribute__((unused)) argc,
-            char __attribute__((unused)) *argv[])
+int sc_main(int argc, char *argv[])
 {
+    // Usage: kpn_example [profile]
+    if(argc > 1 && strcmp(argv[1], "profile") == 0)
+    {
+        // Registers itself, reports at end_of_simulation:
+        new process_profiler("profiler", "kpn_example.folded");
+    }
+
     kpn kahn("kpn");
     sc_start();
     return 0;
@@ -0,0 +1,323 @@
+/*
+ * Copyright 2017 Matthias Jung
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GATE_NETLIST_H
+#define GATE_NETLIST_H
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Netlist of simple combinational gates. Nets are numbered, every net is
+// either a primary input or driven by exactly one gate. levelize() sorts the
+// gates by their level and groups the gates of one level by their type into
+// batches, so that evaluate() computes all nets in a single pass without any
+// events and with one dispatch per batch instead of per gate. Every net has
+// a 64 bit word, one bit per lane, i.e. evaluate() computes 64 independent
+// input vectors at once with plain bitwise operations.
+//
+// Feedback loops like the NOR pair of the rslatch are not combinational and
+// are rejected by levelize(), they have to stay in the delta-cycle model.
+class gate_netlist
+{
+    public:
+    typedef uint32_t net;
+
+    enum op : uint8_t
+    {
+        BUF,
+        NOT,
+        AND,
+        OR,
+        NAND,
+        NOR,
+        XOR
+    };
+
+    // Primary input of the netlist
+    net input()
+    {
+        net n = wire();
+        inputNets.push_back(n);
+        isInput[n] = true;
+        return n;
+    }
+
+    // Net without driver, e.g. for building loops. It has to be driven
+    // later on by assign().
+    net wire()
+    {
+        driver.push_back(none);
+        isInput.push_back(false);
+        levelized = false;
+        return driver.size() - 1;
+    }
+
+    void assign(net out, op type, net a, net b)
+    {
+        if(out >= driver.size() || a >= driver.size() || b >= driver.size())
+        {
+            throw std::runtime_error("Unknown net");
+        }
+        if(driver[out] != none || isInput[out])
+        {
+            throw std::runtime_error("Net " + std::to_string(out)
+                                     + " has multiple drivers");
+        }
+        driver[out] = gates.size();
+        gates.push_back({type, a, b, out});
+        levelized = false;
+    }
+
+    net gate(op type, net a, net b)
+    {
+        net out = wire();
+        assign(out, type, a, b);
+        return out;
+    }
+
+    net gate(op type, net a)
+    {
+        return gate(type, a, a);
+    }
+
+    void output(net n)
+    {
+        outputNets.push_back(n);
+    }
+
+    const std::vector<net>& inputs() const
+    {
+        return inputNets;
+    }
+
+    const std::vector<net>& outputs() const
+    {
+        return outputNets;
+    }
+
+    unsigned int nets() const
+    {
+        return driver.size();
+    }
+
+    unsigned int size() const
+    {
+        return gates.size();
+    }
+
+    unsigned int levels() const
+    {
+        return depth;
+    }
+
+    // Topological sort (Kahn's algorithm) of the gates by their level, the
+    // level of a gate is the length of the longest path from a primary
+    // input. Throws if a net is undriven or the netlist contains a loop.
+    void levelize()
+    {
+        std::vector<unsigned int> level(driver.size(), 0);
+        std::vector<unsigned int> pending(gates.size(), 0);
+        std::vector<std::vector<unsigned int>> fanout(driver.size());
+        std::vector<unsigned int> ready;
+
+        for(net n = 0; n < driver.size(); n++)
+        {
+            if(driver[n] == none && !isInput[n])
+            {
+                throw std::runtime_error("Net " + std::to_string(n)
+                                         + " is not driven");
+            }
+        }
+
+        for(unsigned int g = 0; g < gates.size(); g++)
+        {
+            for(net n : {gates[g].a, gates[g].b})
+            {
+                if(!isInput[n])
+                {
+                    pending[g]++;
+                    fanout[n].push_back(g);
+                }
+            }
+            if(pending[g] == 0)
+            {
+                ready.push_back(g);
+            }
+        }
+
+        std::vector<gate_t> sorted;
+        sorted.reserve(gates.size());
+        depth = 0;
+
+        // Topological order, the inputs of a gate are computed before it:
+        for(unsigned int i = 0; i < ready.size(); i++)
+        {
+            const gate_t &g = gates[ready[i]];
+            level[g.out] = std::max(level[g.a], level[g.b]) + 1;
+            depth = std::max(depth, level[g.out]);
+            sorted.push_back(g);
+
+            for(unsigned int f : fanout[g.out])
+            {
+                if(--pending[f] == 0)
+                {
+                    ready.push_back(f);
+                }
+            }
+        }
+
+        if(sorted.size() != gates.size())
+        {
+            throw std::runtime_error("Netlist contains a combinational loop");
+        }
+
+        // Gates of one level are independent of each other, so they can be
+        // ordered by type:
+        std::stable_sort(sorted.begin(), sorted.end(),
+            [&level](const gate_t &x, const gate_t &y)
+            {
+                if(level[x.out] != level[y.out])
+                {
+                    return level[x.out] < level[y.out];
+                }
+                return x.type < y.type;
+            });
+
+        order = sorted;
+        batches.clear();
+        for(unsigned int i = 0; i < order.size(); i++)
+        {
+            if(batches.empty() || batches.back().type != order[i].type)
+            {
+                batches.push_back({order[i].type, i, i});
+            }
+            batches.back().end = i + 1;
+        }
+        levelized = true;
+    }
+
+    // Number of batches evaluate() dispatches on:
+    unsigned int batchCount() const
+    {
+        return batches.size();
+    }
+
+    std::vector<uint64_t> values() const
+    {
+        return std::vector<uint64_t>(driver.size(), 0);
+    }
+
+    // Value of lane 0:
+    static bool get(const std::vector<uint64_t> &v, net n)
+    {
+        return v[n] & 1;
+    }
+
+    // Sets all lanes to the same value:
+    static void set(std::vector<uint64_t> &v, net n, bool value)
+    {
+        v[n] = value ? ~uint64_t(0) : 0;
+    }
+
+    // Computes all nets from the primary inputs in v, in all lanes:
+    void evaluate(std::vector<uint64_t> &v) const
+    {
+        if(!levelized)
+        {
+            throw std::runtime_error("Netlist is not levelized");
+        }
+
+        uint64_t *x = v.data();
+        for(const batch &b : batches)
+        {
+            const gate_t *g = order.data() + b.begin;
+            const gate_t *end = order.data() + b.end;
+
+            switch(b.type)
+            {
+                case BUF:
+                    for(; g != end; g++) x[g->out] = x[g->a];
+                    break;
+                case NOT:
+                    for(; g != end; g++) x[g->out] = ~x[g->a];
+                    break;
+                case AND:
+                    for(; g != end; g++) x[g->out] = x[g->a] & x[g->b];
+                    break;
+                case OR:
+                    for(; g != end; g++) x[g->out] = x[g->a] | x[g->b];
+                    break;
+                case NAND:
+                    for(; g != end; g++) x[g->out] = ~(x[g->a] & x[g->b]);
+                    break;
+                case NOR:
+                    for(; g != end; g++) x[g->out] = ~(x[g->a] | x[g->b]);
+                    break;
+                default:
+                    for(; g != end; g++) x[g->out] = x[g->a] ^ x[g->b];
+                    break;
+            }
+        }
+    }
+
+    private:
+    struct gate_t
+    {
+        op type;
+        net a;
+        net b;
+        net out;
+    };
+
+    // Gates order[begin] .. order[end - 1] of the same type and level:
+    struct batch
+    {
+        op type;
+        unsigned int begin;
+        unsigned int end;
+    };
+
+    enum : unsigned int { none = ~0u }; // Not driven (yet)
+
+    std::vector<gate_t> gates;
+    std::vector<gate_t> order;
+    std::vector<batch> batches;
+    std::vector<unsigned int> driver;
+    std::vector<bool> isInput;
+    std::vector<net> inputNets;
+    std::vector<net> outputNets;
+    unsigned int depth = 0;
+    bool levelized = false;
+};
+
+#endif // GATE_NETLIST_H
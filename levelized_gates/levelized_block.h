@@ -0,0 +1,109 @@
+/*
+ * Copyright 2017 Matthias Jung
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LEVELIZED_BLOCK_H
+#define LEVELIZED_BLOCK_H
+
+#include <systemc.h>
+
+#include "gate_netlist.h"
+
+// Replaces a region of gate modules that are connected by sc_signals. Only
+// the boundary of the region consists of ports: one SC_METHOD activation
+// per input change evaluates the whole levelized netlist, instead of one
+// process activation and one delta cycle per gate.
+SC_MODULE(levelized_block)
+{
+    sc_vector<sc_in<bool> > in;
+    sc_vector<sc_out<bool> > out;
+
+    unsigned long activations;
+
+    SC_HAS_PROCESS(levelized_block);
+    levelized_block(const sc_module_name &name, const gate_netlist &netlist) :
+        sc_module(name),
+        in("in", netlist.inputs().size()),
+        out("out", netlist.outputs().size()),
+        activations(0),
+        netlist(netlist),
+        values(netlist.values())
+    {
+        try
+        {
+            this->netlist.levelize();
+        }
+        catch(const std::exception &e)
+        {
+            SC_REPORT_FATAL(this->name(), e.what());
+        }
+
+        SC_METHOD(process);
+        for(unsigned int i = 0; i < in.size(); i++)
+        {
+            sensitive << in[i];
+        }
+    }
+
+    void process()
+    {
+        activations++;
+
+        const std::vector<gate_netlist::net> &inputs = netlist.inputs();
+        for(unsigned int i = 0; i < inputs.size(); i++)
+        {
+            gate_netlist::set(values, inputs[i], in[i].read());
+        }
+
+        netlist.evaluate(values);
+
+        const std::vector<gate_netlist::net> &outputs = netlist.outputs();
+        for(unsigned int i = 0; i < outputs.size(); i++)
+        {
+            out[i].write(gate_netlist::get(values, outputs[i]));
+        }
+    }
+
+    // Depth of the levelized copy of the netlist:
+    unsigned int levels() const
+    {
+        return netlist.levels();
+    }
+
+    unsigned int batches() const
+    {
+        return netlist.batchCount();
+    }
+
+    private:
+    gate_netlist netlist;
+    std::vector<uint64_t> values;
+};
+
+#endif // LEVELIZED_BLOCK_H
@@ -0,0 +1,199 @@
+/*
+ * Copyright 2017 Matthias Jung
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <systemc.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "levelized_block.h"
+
+// Gates of the delta-cycle model, as in not_chain and feedback_loop:
+SC_MODULE(NOT)
+{
+    sc_in<bool> in;
+    sc_out<bool> out;
+
+    SC_CTOR(NOT) : in("in"), out("out")
+    {
+        SC_METHOD(process);
+        sensitive << in;
+    }
+
+    void process()
+    {
+        out.write(!in.read());
+    }
+};
+
+SC_MODULE(NOR)
+{
+    sc_in<bool> A;
+    sc_in<bool> B;
+    sc_out<bool> Z;
+
+    SC_CTOR(NOR) : A("A"), B("B"), Z("Z")
+    {
+        SC_METHOD(process);
+        sensitive << A << B;
+    }
+
+    void process()
+    {
+        Z.write(!(A.read() | B.read()));
+    }
+};
+
+int sc_main(int argc, char *argv[])
+{
+    // Usage: levelized_gates [compare|delta|levelized] [stages] [changes]
+    //
+    // Chain of alternating NOT and NOR gates, the second input of every NOR
+    // is the common input B:
+    //
+    //     A--NOT--NOR--NOT--NOR-- ... --Z
+    //              |         |
+    //     B--------+---------+
+    //
+    // compare runs the delta-cycle model and the levelized model side by
+    // side and checks that both produce the same Z after every change.
+    std::string mode = argc > 1 ? argv[1] : "compare";
+    unsigned int stages = argc > 2 ? atoi(argv[2]) : 1000;
+    unsigned int changes = argc > 3 ? atoi(argv[3]) : 10000;
+
+    bool delta = mode == "compare" || mode == "delta";
+    bool levelized = mode == "compare" || mode == "levelized";
+
+    if(stages == 0 || (!delta && !levelized))
+    {
+        std::cerr << "Usage: " << argv[0]
+                  << " [compare|delta|levelized] [stages] [changes]"
+                  << std::endl;
+        return 1;
+    }
+
+    sc_signal<bool> A("A"), B("B"), Z("Z");
+
+    // Delta-cycle model: one module and one signal per gate
+    sc_vector<sc_signal<bool> > net("net", delta ? stages - 1 : 0);
+    std::vector<sc_module*> gates;
+
+    for(unsigned int i = 0; delta && i < stages; i++)
+    {
+        sc_signal<bool> &in = i == 0 ? A : net[i-1];
+        sc_signal<bool> &out = i == stages - 1 ? Z : net[i];
+        std::string name = "gate" + std::to_string(i);
+
+        if(i % 2 == 0)
+        {
+            NOT *g = new NOT(name.c_str());
+            g->in(in);
+            g->out(out);
+            gates.push_back(g);
+        }
+        else
+        {
+            NOR *g = new NOR(name.c_str());
+            g->A(in);
+            g->B(B);
+            g->Z(out);
+            gates.push_back(g);
+        }
+    }
+
+    // Levelized model: the same chain as gate netlist in one module
+    gate_netlist netlist;
+    gate_netlist::net a = netlist.input();
+    gate_netlist::net b = netlist.input();
+    gate_netlist::net n = a;
+    for(unsigned int i = 0; i < stages; i++)
+    {
+        if(i % 2 == 0)
+        {
+            n = netlist.gate(gate_netlist::NOT, n);
+        }
+        else
+        {
+            n = netlist.gate(gate_netlist::NOR, n, b);
+        }
+    }
+    netlist.output(n);
+
+    sc_signal<bool> Zlevelized("Zlevelized");
+    levelized_block *block = nullptr;
+
+    if(levelized)
+    {
+        block = new levelized_block("block", netlist);
+        block->in[0](A);
+        block->in[1](B);
+        block->out[0](Zlevelized);
+    }
+
+    unsigned int mismatches = 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for(unsigned int i = 0; i < changes; i++)
+    {
+        A.write(i % 2);
+        B.write((i / 7) % 3 == 2);
+        sc_start(1, SC_NS);
+
+        if(delta && levelized && Z.read() != Zlevelized.read())
+        {
+            mismatches++;
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    double time = std::chrono::duration<double>(end - start).count();
+
+    std::cout << mode << ": " << stages << " stages, "
+              << changes << " input changes" << std::endl
+              << "    delta cycles:   " << sc_delta_count() << std::endl;
+    if(block)
+    {
+        std::cout << "    levels:         " << block->levels()
+                  << " (" << block->batches() << " batches)" << std::endl
+                  << "    activations:    " << block->activations
+                  << std::endl;
+    }
+    std::cout << "    host time:      " << time << " s" << std::endl;
+
+    if(delta && levelized)
+    {
+        std::cout << "    mismatches:     " << mismatches << std::endl;
+        return mismatches == 0 ? 0 : 1;
+    }
+    return 0;
+}
@@ -0,0 +1,304 @@
+/*
+ * Copyright 2017 Matthias Jung
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ARBITER_H
+#define ARBITER_H
+
+#include <systemc.h>
+
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+// Selects the next owner of the bus out of the pending requests, which are
+// given in the order of their arrival (the grant queue).
+class arbitration_policy
+{
+    public:
+    virtual ~arbitration_policy()
+    {
+    }
+
+    virtual const char* name() const = 0;
+    virtual unsigned int select(const std::vector<unsigned int> &queue) = 0;
+};
+
+// The master after the last granted one gets the bus
+class round_robin : public arbitration_policy
+{
+    public:
+    round_robin(unsigned int masters) : masters(masters), last(masters - 1)
+    {
+    }
+
+    const char* name() const
+    {
+        return "round robin";
+    }
+
+    unsigned int select(const std::vector<unsigned int> &queue)
+    {
+        unsigned int best = queue[0];
+        for(unsigned int m : queue)
+        {
+            if(distance(m) < distance(best))
+            {
+                best = m;
+            }
+        }
+        last = best;
+        return best;
+    }
+
+    private:
+    unsigned int masters;
+    unsigned int last;
+
+    unsigned int distance(unsigned int m) const
+    {
+        return (m + masters - last - 1) % masters;
+    }
+};
+
+// The master with the lowest number gets the bus
+class fixed_priority : public arbitration_policy
+{
+    public:
+    const char* name() const
+    {
+        return "fixed priority";
+    }
+
+    unsigned int select(const std::vector<unsigned int> &queue)
+    {
+        unsigned int best = queue[0];
+        for(unsigned int m : queue)
+        {
+            if(m < best)
+            {
+                best = m;
+            }
+        }
+        return best;
+    }
+};
+
+// Smooth weighted round robin: under permanent contention every master gets
+// a share of the grants that is proportional to its weight, and the grants
+// of a master are spread evenly instead of being handed out in bursts.
+class weighted : public arbitration_policy
+{
+    public:
+    weighted(const std::vector<int> &weights) :
+        weights(weights),
+        current(weights.size(), 0)
+    {
+    }
+
+    const char* name() const
+    {
+        return "weighted";
+    }
+
+    unsigned int select(const std::vector<unsigned int> &queue)
+    {
+        int total = 0;
+        unsigned int best = queue[0];
+        for(unsigned int m : queue)
+        {
+            current[m] += weights[m];
+            total += weights[m];
+            if(current[m] > current[best])
+            {
+                best = m;
+            }
+        }
+        current[best] -= total;
+        return best;
+    }
+
+    private:
+    std::vector<int> weights;
+    std::vector<int> current;
+};
+
+class arbiter_if : virtual public sc_interface
+{
+    public:
+    // Blocks until the bus is granted to the master
+    virtual void lock(unsigned int master) = 0;
+    virtual void unlock(unsigned int master) = 0;
+};
+
+// Bus arbiter channel as replacement of an sc_mutex: requesters are queued
+// instead of polling with trylock() or competing for the wake-up of lock().
+// All requests of one delta cycle are arbitrated together by the policy,
+// and only the granted master is woken up by its own grant event.
+class arbiter : public sc_module, public arbiter_if
+{
+    public:
+    struct statistics
+    {
+        unsigned long long grants;
+        sc_time waitTime;
+        sc_time maxWaitTime;
+        sc_time busyTime;
+    };
+
+    SC_HAS_PROCESS(arbiter);
+    arbiter(const sc_module_name &name,
+            unsigned int masters,
+            arbitration_policy *policy) :
+        sc_module(name),
+        policy(policy),
+        owner(none),
+        grant(masters),
+        requestTime(masters),
+        stats(masters, statistics())
+    {
+        SC_METHOD(arbitrate);
+        sensitive << arbitrateEvent;
+        dont_initialize();
+    }
+
+    ~arbiter()
+    {
+        delete policy;
+    }
+
+    void lock(unsigned int master)
+    {
+        check(master);
+        requestTime[master] = sc_time_stamp();
+        queue.push_back(master);
+        arbitrateEvent.notify(SC_ZERO_TIME);
+        do
+        {
+            wait(grant[master]);
+        } while(owner != master);
+    }
+
+    void unlock(unsigned int master)
+    {
+        check(master);
+        if(owner != master)
+        {
+            SC_REPORT_ERROR(name(), "Unlock by a master that is not the owner");
+            return;
+        }
+        stats[master].busyTime += sc_time_stamp() - grantTime;
+        owner = none;
+        if(!queue.empty())
+        {
+            arbitrateEvent.notify(SC_ZERO_TIME);
+        }
+    }
+
+    const statistics& get_statistics(unsigned int master) const
+    {
+        return stats[master];
+    }
+
+    void report(std::ostream &os = std::cout) const
+    {
+        double now = sc_time_stamp().to_seconds();
+
+        os << name() << " (" << policy->name() << "):" << std::endl
+           << "    master    grants    avg wait     max wait"
+           << "     utilization" << std::endl;
+
+        for(unsigned int m = 0; m < stats.size(); m++)
+        {
+            const statistics &s = stats[m];
+            sc_time average = s.grants ? s.waitTime / double(s.grants)
+                                       : SC_ZERO_TIME;
+            os << std::setw(10) << m
+               << std::setw(10) << s.grants
+               << std::setw(13) << average
+               << std::setw(13) << s.maxWaitTime
+               << std::setw(15) << std::fixed << std::setprecision(3)
+               << (now > 0 ? s.busyTime.to_seconds() / now : 0.0)
+               << std::defaultfloat << std::endl;
+        }
+    }
+
+    private:
+    enum : unsigned int { none = ~0u };
+
+    arbitration_policy *policy;
+    unsigned int owner;
+    sc_time grantTime;
+    std::vector<unsigned int> queue;
+    std::vector<sc_event> grant;
+    std::vector<sc_time> requestTime;
+    std::vector<statistics> stats;
+    sc_event arbitrateEvent;
+
+    void check(unsigned int master) const
+    {
+        if(master >= grant.size())
+        {
+            SC_REPORT_FATAL(name(), "Unknown master");
+        }
+    }
+
+    void arbitrate()
+    {
+        if(owner != none || queue.empty())
+        {
+            return;
+        }
+
+        unsigned int master = policy->select(queue);
+        for(unsigned int i = 0; i < queue.size(); i++)
+        {
+            if(queue[i] == master)
+            {
+                queue.erase(queue.begin() + i);
+                break;
+            }
+        }
+
+        sc_time waited = sc_time_stamp() - requestTime[master];
+        statistics &s = stats[master];
+        s.grants++;
+        s.waitTime += waited;
+        if(waited > s.maxWaitTime)
+        {
+            s.maxWaitTime = waited;
+        }
+
+        owner = master;
+        grantTime = sc_time_stamp();
+        grant[master].notify();
+    }
+};
+
+#endif // ARBITER_H
@@ -33,8 +33,12 @@
 
 
 #include <iostream>
+#include <random>
+#include <string>
 #include <systemc.h>
 
+#include "arbiter.h"
+
 using namespace std;
 
 SC_MODULE (sc_mutex_example) {
@@ -86,9 +90,85 @@ SC_MODULE (sc_mutex_example) {
 };
 
 
-int sc_main(int __attribute__((unused)) argc,
-            char __attribute__((unused)) *argv[])
+// Bus master that alternates between a random number of idle cycles and a
+// random number of bus cycles. While it waits for the bus it is not woken
+// up until the arbiter grants the bus to it.
+SC_MODULE(bus_master)
+{
+    sc_port<arbiter_if> bus;
+
+    SC_HAS_PROCESS(bus_master);
+    bus_master(const sc_module_name &name,
+               unsigned int id,
+               sc_time cycle,
+               unsigned int idle) :
+        sc_module(name),
+        id(id),
+        cycle(cycle),
+        idle(idle)
+    {
+        SC_THREAD(process);
+    }
+
+    void process()
+    {
+        std::mt19937 generator(id);
+        while (true) {
+            wait((generator() % idle + 1) * cycle);
+            bus->lock(id);
+            wait((generator() % 4 + 1) * cycle); // Bus access
+            bus->unlock(id);
+        }
+    }
+
+    private:
+    unsigned int id;
+    sc_time cycle;
+    unsigned int idle;
+};
+
+// Usage: mutex_example arbiter [round_robin|priority|weighted] [masters] [us]
+int arbiter_example(int argc, char *argv[])
+{
+    std::string policyName = argc > 2 ? argv[2] : "round_robin";
+    unsigned int masters = argc > 3 ? atoi(argv[3]) : 32;
+    double duration = argc > 4 ? atof(argv[4]) : 100;
+
+    arbitration_policy *policy;
+    if (policyName == "priority") {
+        policy = new fixed_priority();
+    } else if (policyName == "weighted") {
+        // Weights 1, 2, 3, 4, 1, 2, ...
+        std::vector<int> weights;
+        for (unsigned int m = 0; m < masters; m++) {
+            weights.push_back(1 + m % 4);
+        }
+        policy = new weighted(weights);
+    } else {
+        policy = new round_robin(masters);
+    }
+
+    arbiter bus("bus", masters, policy);
+
+    std::vector<bus_master*> m;
+    for (unsigned int i = 0; i < masters; i++) {
+        std::string name = "master" + std::to_string(i);
+        m.push_back(new bus_master(name.c_str(), i, sc_time(1, SC_NS),
+                                   4 * masters));
+        m.back()->bus(bus);
+    }
+
+    sc_start(duration, SC_US);
+    bus.report();
+    return 0;
+}
+
+int sc_main(int argc, char *argv[])
 {
+    if (argc > 1 && std::string(argv[1]) == "arbiter") {
+        return arbiter_example(argc, argv);
+    }
+
     sc_clock clock ("my_clock",sc_time(1,SC_NS));
 
     sc_mutex_example object("wait");
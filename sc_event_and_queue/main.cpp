@@ -32,9 +32,14 @@
  */
 
 
+#include <chrono>
 #include <iostream>
+#include <random>
+#include <string>
 #include <systemc.h>
 
+#include "timing_wheel.h"
+
 using namespace std;
 
 SC_MODULE(eventTester)
@@ -90,9 +95,78 @@ SC_MODULE(eventQueueTester)
     }
 };
 
-int sc_main(int __attribute__((unused)) argc,
-            char __attribute__((unused)) *argv[])
+// Issues n notifications with random delays up to 1 ms at once and counts
+// the triggers of the queue:
+SC_MODULE(queueBenchmark)
 {
+    sc_port<sc_event_queue_if> queue;
+    unsigned int n;
+    unsigned int triggers;
+
+    SC_HAS_PROCESS(queueBenchmark);
+    queueBenchmark(const sc_module_name &name, unsigned int n) :
+        sc_module(name),
+        n(n),
+        triggers(0)
+    {
+        SC_THREAD(triggerProcess);
+        SC_METHOD(sensitiveProcess);
+        sensitive << queue;
+        dont_initialize();
+    }
+
+    void triggerProcess()
+    {
+       std::mt19937 generator(0);
+       for(unsigned int i = 0; i < n; i++)
+       {
+           queue->notify(generator() % 1000000, SC_NS);
+       }
+    }
+
+    void sensitiveProcess()
+    {
+        triggers++;
+    }
+};
+
+// Usage: sc_event_and_queue [sc_event_queue|timing_wheel] [notifications]
+int benchmark(const std::string &type, unsigned int n)
+{
+    sc_event_queue *eventQueue = nullptr;
+    timing_wheel_queue *wheel = nullptr;
+    queueBenchmark b("benchmark", n);
+
+    if(type == "timing_wheel")
+    {
+        wheel = new timing_wheel_queue("queue");
+        b.queue(*wheel);
+    }
+    else
+    {
+        eventQueue = new sc_event_queue("queue");
+        b.queue(*eventQueue);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    sc_start();
+    auto end = std::chrono::steady_clock::now();
+    double time = std::chrono::duration<double>(end - start).count();
+
+    cout << type << ": " << n << " notifications, "
+         << b.triggers << " triggers" << endl
+         << "    host time:      " << time << " s" << endl;
+
+    return b.triggers == n ? 0 : 1;
+}
+
+int sc_main(int argc, char *argv[])
+{
+    if(argc > 1)
+    {
+        return benchmark(argv[1], argc > 2 ? atoi(argv[2]) : 1000000);
+    }
+
     eventTester et("et");
     eventQueueTester eqt("eqt");
     sc_start();
@@ -0,0 +1,337 @@
+/*
+ * Copyright 2017 Matthias Jung
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TIMING_WHEEL_H
+#define TIMING_WHEEL_H
+
+#include <systemc.h>
+
+#include <cstdint>
+#include <vector>
+
+// Event queue with the interface of sc_event_queue, which is backed by a
+// hierarchical timing wheel instead of a priority queue. Times are counted
+// in ticks of the time resolution, i.e. they are exact. The wheel has 8
+// levels of 256 slots, one level per byte of the 64 bit tick:
+//
+// A notification for tick t is stored on the level of the highest byte in
+// which t differs from the current tick, in the slot given by that byte of
+// t. Level 0 therefore holds the notifications of the next ticks (only a
+// counter per slot), level 1 those within the current block of 65536 ticks
+// and so on. Insertion is O(1). When the current tick enters the block of a
+// higher level slot, the slot is cascaded, i.e. its notifications move to
+// the lower levels, which is O(1) per notification and level. The next
+// pending slot of a level is found with a 256 bit occupancy bitmap.
+//
+// Only one timed notification of the kernel is pending at any time: either
+// the next expiry or the beginning of the next block that has to be
+// cascaded. Notifications for the same time trigger the event in
+// consecutive delta cycles like in sc_event_queue.
+class timing_wheel_queue : public sc_module, public sc_event_queue_if
+{
+    public:
+    SC_HAS_PROCESS(timing_wheel_queue);
+    timing_wheel_queue(const sc_module_name &name) :
+        sc_module(name),
+        resolution(sc_get_time_resolution()),
+        now(0),
+        pending(0),
+        freeNodes(none)
+    {
+        for(unsigned int l = 0; l < levels; l++)
+        {
+            for(unsigned int w = 0; w < 4; w++)
+            {
+                occupied[l][w] = 0;
+            }
+            for(unsigned int s = 0; s < slots; s++)
+            {
+                head[l][s] = none;
+            }
+        }
+        for(unsigned int s = 0; s < slots; s++)
+        {
+            count[s] = 0;
+        }
+
+        SC_METHOD(expire);
+        sensitive << wakeup;
+        dont_initialize();
+    }
+
+    void notify(double when, sc_time_unit base)
+    {
+        notify(sc_time(when, base));
+    }
+
+    void notify(const sc_time &when)
+    {
+        // Align the wheel with the simulation time, nothing is due before:
+        advance(ticks(sc_time_stamp()));
+        insert(now + ticks(when));
+        pending++;
+        schedule();
+    }
+
+    void cancel_all()
+    {
+        for(unsigned int l = 0; l < levels; l++)
+        {
+            for(unsigned int s = 0; s < slots; s++)
+            {
+                release(head[l][s]);
+                head[l][s] = none;
+            }
+            for(unsigned int w = 0; w < 4; w++)
+            {
+                occupied[l][w] = 0;
+            }
+        }
+        for(unsigned int s = 0; s < slots; s++)
+        {
+            count[s] = 0;
+        }
+        pending = 0;
+        wakeup.cancel();
+        event.cancel();
+    }
+
+    const sc_event& default_event() const
+    {
+        return event;
+    }
+
+    unsigned long long size() const
+    {
+        return pending;
+    }
+
+    virtual const char* kind() const
+    {
+        return "timing_wheel_queue";
+    }
+
+    private:
+    static const unsigned int levels = 8;
+    static const unsigned int slots = 256;
+    enum : uint32_t { none = ~0u };
+
+    struct node
+    {
+        uint64_t tick;
+        uint32_t next;
+    };
+
+    sc_time resolution;
+    uint64_t now;
+    unsigned long long pending;
+
+    uint32_t count[slots];              // Level 0: notifications per tick
+    uint32_t head[levels][slots];       // Levels 1..7: lists of nodes
+    uint64_t occupied[levels][4];       // Occupancy bitmaps of all levels
+    std::vector<node> nodes;
+    uint32_t freeNodes;
+
+    sc_event event;
+    sc_event wakeup;
+
+    uint64_t ticks(const sc_time &t) const
+    {
+        return t.value() / resolution.value();
+    }
+
+    static unsigned int digit(uint64_t tick, unsigned int level)
+    {
+        return (tick >> (8 * level)) & 0xff;
+    }
+
+    void mark(unsigned int level, unsigned int slot)
+    {
+        occupied[level][slot / 64] |= uint64_t(1) << (slot % 64);
+    }
+
+    void unmark(unsigned int level, unsigned int slot)
+    {
+        occupied[level][slot / 64] &= ~(uint64_t(1) << (slot % 64));
+    }
+
+    // First occupied slot of the level at or after the given slot, or slots
+    int first(unsigned int level, unsigned int from) const
+    {
+        for(unsigned int w = from / 64; w < 4; w++)
+        {
+            uint64_t bits = occupied[level][w];
+            if(w == from / 64)
+            {
+                bits &= ~uint64_t(0) << (from % 64);
+            }
+            if(bits)
+            {
+                return w * 64 + __builtin_ctzll(bits);
+            }
+        }
+        return slots;
+    }
+
+    void insert(uint64_t tick)
+    {
+        uint64_t differ = tick ^ now;
+        if(differ < slots)
+        {
+            unsigned int s = digit(tick, 0);
+            count[s]++;
+            mark(0, s);
+            return;
+        }
+
+        unsigned int level = (63 - __builtin_clzll(differ)) / 8;
+        unsigned int s = digit(tick, level);
+
+        uint32_t n;
+        if(freeNodes != none)
+        {
+            n = freeNodes;
+            freeNodes = nodes[n].next;
+        }
+        else
+        {
+            n = nodes.size();
+            nodes.push_back(node());
+        }
+        nodes[n].tick = tick;
+        nodes[n].next = head[level][s];
+        head[level][s] = n;
+        mark(level, s);
+    }
+
+    void release(uint32_t n)
+    {
+        while(n != none)
+        {
+            uint32_t next = nodes[n].next;
+            nodes[n].next = freeNodes;
+            freeNodes = n;
+            n = next;
+        }
+    }
+
+    // Moves the current tick forward and cascades the slots of all levels
+    // whose block is entered:
+    void advance(uint64_t tick)
+    {
+        if(tick == now)
+        {
+            return;
+        }
+
+        uint64_t old = now;
+        now = tick;
+
+        for(unsigned int l = levels - 1; l > 0; l--)
+        {
+            if((old >> (8 * l)) == (tick >> (8 * l)))
+            {
+                continue;
+            }
+
+            unsigned int s = digit(tick, l);
+            uint32_t n = head[l][s];
+            head[l][s] = none;
+            unmark(l, s);
+
+            while(n != none)
+            {
+                uint32_t next = nodes[n].next;
+                insert(nodes[n].tick);
+                nodes[n].next = freeNodes;
+                freeNodes = n;
+                n = next;
+            }
+        }
+    }
+
+    // Next tick at which the wheel has to be looked at: an expiry on level
+    // 0 or the beginning of the next block to be cascaded.
+    bool next(uint64_t &tick) const
+    {
+        int s = first(0, digit(now, 0));
+        if(s < int(slots))
+        {
+            tick = (now & ~uint64_t(0xff)) | s;
+            return true;
+        }
+
+        for(unsigned int l = 1; l < levels; l++)
+        {
+            s = first(l, digit(now, l) + 1);
+            if(s < int(slots))
+            {
+                uint64_t upper = l + 1 < levels
+                               ? (now >> (8 * (l + 1))) << (8 * (l + 1))
+                               : 0;
+                tick = upper | (uint64_t(s) << (8 * l));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void schedule()
+    {
+        uint64_t tick;
+        if(next(tick))
+        {
+            // An earlier notification overrides a later one. The delay is
+            // built from integer ticks, sc_time * double would round:
+            wakeup.notify(sc_time::from_value((tick - now)
+                                              * resolution.value()));
+        }
+    }
+
+    void expire()
+    {
+        advance(ticks(sc_time_stamp()));
+
+        unsigned int s = digit(now, 0);
+        if(count[s] > 0)
+        {
+            if(--count[s] == 0)
+            {
+                unmark(0, s);
+            }
+            pending--;
+            event.notify();
+        }
+
+        schedule();
+    }
+};
+
+#endif // TIMING_WHEEL_H
@@ -0,0 +1,8 @@
+#!/usr/bin/env sh
+# Backpressure example without printing, with the SystemC PEQ and fast_peq.
+# Usage: ./benchmark.sh <build directory> [transactions]
+DIR=${1:-.}
+N=${2:-1000000}
+
+$DIR/tlm_at_backpressure $N
+$DIR/tlm_at_backpressure_fast_peq $N
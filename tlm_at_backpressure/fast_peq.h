@@ -0,0 +1,217 @@
+/*
+ * Copyright 2017 Matthias Jung
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FAST_PEQ_H
+#define FAST_PEQ_H
+
+#include <systemc>
+#include <tlm.h>
+#include <tlm_utils/peq_with_cb_and_phase.h>
+
+#include <algorithm>
+#include <vector>
+
+// Payload event queue with the interface of
+// tlm_utils::peq_with_cb_and_phase. Instead of allocating an entry per
+// notification and keeping the timed entries in a time ordered list, the
+// timed entries are kept in a binary heap on a vector, which keeps its
+// capacity, i.e. after warm-up no memory is allocated anymore. Zero-delay
+// and immediate notifications bypass the heap in a fast lane of plain
+// vectors. The order of the callbacks is the same as in the original:
+// immediate, then delta, then timed notifications in the order of their
+// time and, for equal times, of their insertion.
+template <class OWNER, class TYPES = tlm::tlm_base_protocol_types>
+class fast_peq : public sc_core::sc_module
+{
+    public:
+    typedef typename TYPES::tlm_payload_type tlm_payload_type;
+    typedef typename TYPES::tlm_phase_type tlm_phase_type;
+    typedef void (OWNER::*callback)(tlm_payload_type&, const tlm_phase_type&);
+
+    SC_HAS_PROCESS(fast_peq);
+    fast_peq(sc_core::sc_module_name name, OWNER *owner, callback cb) :
+        sc_core::sc_module(name),
+        owner(owner),
+        cb(cb),
+        sequence(0)
+    {
+        SC_METHOD(fire);
+        sensitive << event;
+        dont_initialize();
+    }
+
+    // Same constructor as peq_with_cb_and_phase, the queue is a child
+    // named "peq" of its owner:
+    fast_peq(OWNER *owner, callback cb) :
+        fast_peq("peq", owner, cb)
+    {
+    }
+
+    void notify(tlm_payload_type &t,
+                const tlm_phase_type &p,
+                const sc_core::sc_time &when)
+    {
+        if(when == sc_core::SC_ZERO_TIME)
+        {
+            // Processed in the next delta cycle, which has the other parity:
+            delta[sc_core::sc_delta_count() & 1].push_back(entry(&t, p));
+            event.notify(sc_core::SC_ZERO_TIME);
+        }
+        else
+        {
+            timed_entry e;
+            e.time = sc_core::sc_time_stamp() + when;
+            e.sequence = sequence++;
+            e.payload = entry(&t, p);
+            timed.push_back(e);
+            std::push_heap(timed.begin(), timed.end(), later);
+            event.notify(when);
+        }
+    }
+
+    void notify(tlm_payload_type &t, const tlm_phase_type &p)
+    {
+        immediate.push_back(entry(&t, p));
+        event.notify();
+    }
+
+    void cancel_all()
+    {
+        immediate.clear();
+        delta[0].clear();
+        delta[1].clear();
+        timed.clear();
+        event.cancel();
+    }
+
+    private:
+    struct entry
+    {
+        tlm_payload_type *trans;
+        tlm_phase_type phase;
+
+        entry()
+        {
+        }
+
+        entry(tlm_payload_type *trans, const tlm_phase_type &phase) :
+            trans(trans),
+            phase(phase)
+        {
+        }
+    };
+
+    struct timed_entry
+    {
+        sc_core::sc_time time;
+        unsigned long long sequence;
+        entry payload;
+    };
+
+    OWNER *owner;
+    callback cb;
+    unsigned long long sequence;
+
+    std::vector<entry> immediate;
+    std::vector<entry> delta[2];
+    std::vector<timed_entry> timed;
+    std::vector<entry> batch;
+    sc_core::sc_event event;
+
+    // Comparison for a min-heap on (time, sequence):
+    static bool later(const timed_entry &a, const timed_entry &b)
+    {
+        if(a.time != b.time)
+        {
+            return a.time > b.time;
+        }
+        return a.sequence > b.sequence;
+    }
+
+    // Calls the callbacks of the given entries. The vector is swapped into
+    // a local batch first, since the callbacks may insert new entries.
+    void call(std::vector<entry> &entries)
+    {
+        batch.swap(entries);
+        for(const entry &e : batch)
+        {
+            (owner->*cb)(*e.trans, e.phase);
+        }
+        batch.clear();
+    }
+
+    void fire()
+    {
+        // Immediate notifications of this evaluation phase:
+        while(!immediate.empty())
+        {
+            call(immediate);
+        }
+
+        // Delta notifications of the previous delta cycle:
+        std::vector<entry> &due = delta[(sc_core::sc_delta_count() & 1) ^ 1];
+        if(!due.empty())
+        {
+            call(due);
+        }
+
+        // Timed notifications for now:
+        sc_core::sc_time now = sc_core::sc_time_stamp();
+        while(!timed.empty() && timed.front().time == now)
+        {
+            entry e = timed.front().payload;
+            std::pop_heap(timed.begin(), timed.end(), later);
+            timed.pop_back();
+            (owner->*cb)(*e.trans, e.phase);
+        }
+
+        // Schedule the next activation:
+        if(!delta[0].empty() || !delta[1].empty())
+        {
+            event.notify(sc_core::SC_ZERO_TIME);
+        }
+        else if(!timed.empty())
+        {
+            event.notify(timed.front().time - now);
+        }
+    }
+};
+
+// The AT examples use payload_event_queue, which is the SystemC PEQ unless
+// they are compiled with FAST_PEQ:
+#ifdef FAST_PEQ
+template <class OWNER>
+using payload_event_queue = fast_peq<OWNER>;
+#else
+template <class OWNER>
+using payload_event_queue = tlm_utils::peq_with_cb_and_phase<OWNER>;
+#endif
+
+#endif // FAST_PEQ_H
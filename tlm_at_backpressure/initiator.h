@@ -40,6 +40,7 @@
 #include "../tlm_memory_manager/memory_manager.h"
 #include "../tlm_protocol_checker/tlm2_base_protocol_checker.h"
 #include "../tlm_at_1/util.h"
+#include "fast_peq.h"
 
 using namespace sc_core;
 using namespace sc_dt;
@@ -58,12 +59,17 @@ class Initiator: public sc_module, public tlm::tlm_bw_transport_if<>
     int data[16];
     tlm::tlm_generic_payload* requestInProgress;
     sc_event endRequest;
-    tlm_utils::peq_with_cb_and_phase<Initiator> peq;
+    payload_event_queue<Initiator> peq;
 
     public:
+    unsigned int length;
+    bool verbose;
+
     SC_CTOR(Initiator): socket("socket"),
                         requestInProgress(0),
-                        peq(this, &Initiator::peqCallback)
+                        peq(this, &Initiator::peqCallback),
+                        length(LENGTH),
+                        verbose(true)
     {
         socket.bind(*this);
 
@@ -83,7 +89,7 @@ class Initiator: public sc_module, public tlm::tlm_bw_transport_if<>
         sc_time delay;
 
         // Generate a sequence of random transactions
-        for (int i = 0; i < LENGTH; i++)
+        for (unsigned int i = 0; i < length; i++)
         {
             int adr = rand();
             tlm::tlm_command cmd = static_cast<tlm::tlm_command>(rand() % 2);
@@ -113,12 +119,15 @@ class Initiator: public sc_module, public tlm::tlm_bw_transport_if<>
             // Timing annot. models processing time of initiator prior to call
             delay = sc_time(0, SC_NS);
 
-            cout << "\033[1;31m"
-                 << "(I) @"  << setfill(' ') << setw(12) << sc_time_stamp()
-                 << ": " << setw(12) << (cmd ? "Write to " : "Read from ")
-                 << "Addr = " << setfill('0') << setw(8) << dec << adr
-                 << " Data = " << "0x" << setfill('0') << setw(8)
-                 << hex << data[i%16] << "\033[0m" << endl;
+            if (verbose)
+            {
+                cout << "\033[1;31m"
+                     << "(I) @"  << setfill(' ') << setw(12) << sc_time_stamp()
+                     << ": " << setw(12) << (cmd ? "Write to " : "Read from ")
+                     << "Addr = " << setfill('0') << setw(8) << dec << adr
+                     << " Data = " << "0x" << setfill('0') << setw(8)
+                     << hex << data[i%16] << "\033[0m" << endl;
+            }
 
             // Non-blocking transport call on the forward path
             tlm::tlm_sync_enum status;
@@ -213,12 +222,15 @@ class Initiator: public sc_module, public tlm::tlm_bw_transport_if<>
         sc_dt::uint64    adr = trans.get_address();
         int*             ptr = reinterpret_cast<int*>(trans.get_data_ptr());
 
-        cout << "\033[1;31m"
-             << "(I) @"  << setfill(' ') << setw(12) << sc_time_stamp()
-             << ": " << setw(12) << (cmd ? "Check Write " : "Check Read ")
-             << "Addr = " << setfill('0') << setw(8) << dec << adr
-             << " Data = " << "0x" << setfill('0') << setw(8) << hex << *ptr
-             << "\033[0m" << endl;
+        if (verbose)
+        {
+            cout << "\033[1;31m"
+                 << "(I) @"  << setfill(' ') << setw(12) << sc_time_stamp()
+                 << ": " << setw(12) << (cmd ? "Check Write " : "Check Read ")
+                 << "Addr = " << setfill('0') << setw(8) << dec << adr
+                 << " Data = " << "0x" << setfill('0') << setw(8) << hex << *ptr
+                 << "\033[0m" << endl;
+        }
 
         if (cmd == tlm::TLM_READ_COMMAND) // Check if Target did the right thing
         {
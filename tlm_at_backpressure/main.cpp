@@ -31,6 +31,8 @@
  *     - Matthias Jung
  */
 
+#include <chrono>
+#include <cstdlib>
 #include <iomanip>
 #include <systemc>
 #include <tlm.h>
@@ -44,14 +46,22 @@ using namespace sc_core;
 using namespace sc_dt;
 using namespace std;
 
-int sc_main (int __attribute__((unused)) sc_argc,
-             char __attribute__((unused)) *sc_argv[])
+int sc_main (int sc_argc, char *sc_argv[])
 {
     cout << std::endl;
 
     Initiator* initiator = new Initiator("initiator");
     Target* target = new Target("target", 8 /* Buffer Size */);
 
+    // Benchmark mode: tlm_at_backpressure <transactions>
+    bool benchmark = sc_argc > 1;
+    if (benchmark)
+    {
+        initiator->length = atoi(sc_argv[1]);
+        initiator->verbose = false;
+        target->verbose = false;
+    }
+
     tlm_utils::tlm2_base_protocol_checker<> *chk =
         new tlm_utils::tlm2_base_protocol_checker<>("chk");
 
@@ -59,6 +69,20 @@ int sc_main (int __attribute__((unused)) sc_argc,
     initiator->socket.bind(chk->target_socket);
     chk->initiator_socket.bind(target->socket);
 
+    auto start = std::chrono::steady_clock::now();
     sc_start();
+    auto end = std::chrono::steady_clock::now();
+
+    if (benchmark)
+    {
+#ifdef FAST_PEQ
+        cout << "fast_peq: ";
+#else
+        cout << "peq_with_cb_and_phase: ";
+#endif
+        cout << dec << initiator->length << " transactions, host time "
+             << std::chrono::duration<double>(end - start).count() << " s"
+             << endl;
+    }
     return 0;
 }
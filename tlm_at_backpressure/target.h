@@ -42,6 +42,7 @@
 #include "../tlm_memory_manager/memory_manager.h"
 #include "../tlm_protocol_checker/tlm2_base_protocol_checker.h"
 #include "../tlm_at_1/util.h"
+#include "fast_peq.h"
 
 using namespace sc_core;
 using namespace sc_dt;
@@ -58,12 +59,14 @@ class Target: public sc_module, public tlm::tlm_fw_transport_if<>
     protected:
     bool responseInProgress;
     tlm::tlm_generic_payload* endRequestPending;
-    tlm_utils::peq_with_cb_and_phase<Target> peq;
+    payload_event_queue<Target> peq;
     unsigned int numberOfTransactions;
     unsigned int bufferSize;
     std::queue<tlm::tlm_generic_payload*> responseQueue;
 
     public:
+    bool verbose;
+
     SC_HAS_PROCESS(Target);
     Target(sc_module_name name, unsigned int bufferSize = 8) : sc_module(name),
         socket("socket"),
@@ -71,13 +74,19 @@ class Target: public sc_module, public tlm::tlm_fw_transport_if<>
         endRequestPending(0),
         peq(this, &Target::peqCallback),
         bufferSize(bufferSize),
-        numberOfTransactions(0)
+        numberOfTransactions(0),
+        verbose(true)
     {
         socket.bind(*this);
     }
 
     void printBuffer(int max, int n)
     {
+        if (!verbose)
+        {
+            return;
+        }
+
         std::cout << "\033[1;35m"
                   << "(T) @"  << setfill(' ') << setw(12) << sc_time_stamp()
                   << " Target Buffer: "
@@ -245,13 +254,16 @@ class Target: public sc_module, public tlm::tlm_fw_transport_if<>
             assert( *reinterpret_cast<unsigned int*>(ptr) == adr );
         }
 
-        cout << "\033[1;32m"
-             << "(T) @"  << setfill(' ') << setw(12) << sc_time_stamp()
-             << ": " << setw(12) << (cmd ? "Exec. Write " : "Exec. Read ")
-             << "Addr = " << setfill('0') << setw(8) << dec << adr
-             << " Data = " << "0x" << setfill('0') << setw(8) << hex
-             << *reinterpret_cast<int*>(ptr)
-             << "\033[0m" << endl;
+        if (verbose)
+        {
+            cout << "\033[1;32m"
+                 << "(T) @"  << setfill(' ') << setw(12) << sc_time_stamp()
+                 << ": " << setw(12) << (cmd ? "Exec. Write " : "Exec. Read ")
+                 << "Addr = " << setfill('0') << setw(8) << dec << adr
+                 << " Data = " << "0x" << setfill('0') << setw(8) << hex
+                 << *reinterpret_cast<int*>(ptr)
+                 << "\033[0m" << endl;
+        }
 
         trans.set_response_status( tlm::TLM_OK_RESPONSE );
     }
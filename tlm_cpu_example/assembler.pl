@@ -41,6 +41,25 @@ open(IF, $file);
 my $programmCounter = 0;
 my %labels;
 
+# Immediate layout of the RISC-V B-type (branches) and J-type (jal) formats:
+sub encodeB
+{
+    my $imm = int(shift);
+    return ((($imm >> 12) & 0b1) << 31)
+         | ((($imm >> 5) & 0b111111) << 25)
+         | ((($imm >> 1) & 0b1111) << 8)
+         | ((($imm >> 11) & 0b1) << 7);
+}
+
+sub encodeJ
+{
+    my $imm = int(shift);
+    return ((($imm >> 20) & 0b1) << 31)
+         | ((($imm >> 1) & 0b1111111111) << 21)
+         | ((($imm >> 11) & 0b1) << 20)
+         | ((($imm >> 12) & 0b11111111) << 12);
+}
+
 # Find Labels
 while(<IF>)
 {
@@ -53,7 +72,7 @@ while(<IF>)
         }
         $labels{$1} = $programmCounter;
     }
-    if($_ =~ /^\s*(add|addi|mul|lw|sw|jal|jr|bne|nop)\s+.*\s*$/)
+    if($_ =~ /^\s*(add|addi|mul|lw|sw|jal|jr|bne|fence|nop)\s+.*\s*$/)
     {
         $programmCounter += 4;
     }
@@ -191,7 +210,7 @@ while(<IF>)
 
         $data |= 0b1101111;
         $data |= ($1 & 0b11111) << 7;
-        $data |= ($2 & 0b11111111111111111111) << 12;
+        $data |= encodeJ($2);
 
         printf("$programmCounter:\t%032b:\tjal x$1, $2\n",$data);
         print OF pack('I<',$data);
@@ -208,7 +227,7 @@ while(<IF>)
 
         $data |= 0b1101111;
         $data |= ($1 & 0b11111) << 7;
-        $data |= ($imm & 0b11111111111111111111) << 12;
+        $data |= encodeJ($imm);
 
         printf("$programmCounter:\t%032b:\tjal x$1, $imm ($2)\n",$data);
         print OF pack('I<',$data);
@@ -222,15 +241,10 @@ while(<IF>)
         ($2 >= 0 && $2 < 32)    || die("Register does not exist");
         # TODO: ($3 >= 0 && $3 < 2**12) || die("Out of range");
 
-        my $imm = $3;
-        my $i1 =  (int($imm)) & 0b11111;
-        my $i2 = ((int($imm)) & 0b111111100000) >> 5;
-
         $data |= 0b1100011;
         $data |= (0b001) << 12;
         $data |= ($1 & 0b11111) << 15;
-        $data |= ($i1) << 7;
-        $data |= ($i2) << 25;
+        $data |= encodeB($3);
         $data |= ($2 & 0b11111) << 20;
 
         printf("$programmCounter:\t%032b:\tbne x$1, x$2, $3\n",$data);
@@ -247,20 +261,24 @@ while(<IF>)
 
         my $imm = $labels{$3} - $programmCounter;
 
-        my $i1 =  (int($imm)) & 0b11111;
-        my $i2 = ((int($imm)) & 0b111111100000) >> 5;
-
         $data |= 0b1100011;
         $data |= (0b001) << 12;
         $data |= ($1 & 0b11111) << 15;
-        $data |= ($i1) << 7;
-        $data |= ($i2) << 25;
+        $data |= encodeB($imm);
         $data |= ($2 & 0b11111) << 20;
 
         printf("$programmCounter:\t%032b:\tbne x$1, x$2, $imm ($3)\n",$data);
         print OF pack('I<',$data);
         $programmCounter += 4;
     }
+    elsif($_ =~ /^\s*fence\s*$/)
+    {
+        $data |= 0b0001111;
+
+        printf("$programmCounter:\t%032b:\tfence\n",$data);
+        print OF pack('I<',$data);
+        $programmCounter += 4;
+    }
     elsif($_ =~ /^\s*nop\s*$/)
     {
         printf("$programmCounter:\t%032b:\tnop\n",$data);
@@ -0,0 +1,21 @@
+# Loop bound: 1000 * 100
+addi x6, x0, 1000
+addi x10, x0, 100
+mul x6, x6, x10
+
+#i
+addi x5, x0, 0
+#t1
+addi x7, x0, 1
+#t2
+addi x8, x0, 1
+
+loop:
+    add x9, x8, x7
+    add x7, x0, x8
+    add x8, x0, x9
+
+    addi x5, x5, 1
+    bne x5, x6, loop
+
+fence
@@ -0,0 +1,53 @@
+#!/usr/bin/env sh
+# Aggregate instructions per host second of the multi-core platform.
+# Usage: ./benchmark.sh <path to tlm_cpu_example binary> [quantum in ns]
+BIN=${1:-./tlm_cpu_example}
+QUANTUM=${2:-1000}
+
+perl assembler.pl bench.asm > /dev/null
+
+for CORES in 1 2 4 8 16 32 64
+do
+    $BIN multicore $CORES 0
+    $BIN multicore $CORES $QUANTUM
+done
+
+# Private memories with DMI, sequential and on a pool of host threads:
+for CORES in 1 2 4 8 16 32 64
+do
+    $BIN parallel $CORES $QUANTUM 0
+    $BIN parallel $CORES $QUANTUM $(nproc)
+done
+
+# Shared cache with statistics per core, and private caches of cores that
+# run sequentially:
+for CORES in 1 4 16
+do
+    $BIN multicore $CORES $QUANTUM cache 32 4 64
+    $BIN parallel $CORES $QUANTUM 0 cache 32 4 64
+done
+
+# RV32IM suite, every program checks its result and exits with 0:
+for PROGRAM in benchmarks/*.elf
+do
+    [ $PROGRAM = benchmarks/timer.elf ] && continue
+    [ $PROGRAM = benchmarks/irq.elf ] && continue
+    $BIN program $PROGRAM
+    $BIN program $PROGRAM quantum $QUANTUM
+    $BIN program $PROGRAM quantum $QUANTUM dbt
+    $BIN program $PROGRAM quantum $QUANTUM cache 32 4 64
+    # Overhead of the guest profile, compare with the run without hotspots:
+    $BIN program $PROGRAM quantum $QUANTUM hotspots
+done
+
+# Timer interrupts of the CLINT in decoupled runs:
+$BIN program benchmarks/timer.elf clint
+$BIN program benchmarks/timer.elf quantum $QUANTUM clint
+$BIN program benchmarks/timer.elf quantum $QUANTUM dbt clint
+
+# External interrupts of the device, also together with the CLINT on a
+# multi-core platform:
+$BIN program benchmarks/irq.elf irq
+$BIN program benchmarks/irq.elf quantum $QUANTUM irq
+$BIN program benchmarks/irq.elf quantum $QUANTUM dbt irq
+$BIN multicore 4 $QUANTUM clint irq
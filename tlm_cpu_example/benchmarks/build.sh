@@ -0,0 +1,16 @@
+#!/usr/bin/env sh
+# Builds the benchmark ELF files, either with a GNU RISC-V toolchain:
+#   AS="riscv32-unknown-elf-as -march=rv32im_zicsr" LD=riscv32-unknown-elf-ld ./build.sh
+# or by default with LLVM:
+#   AS="llvm-mc -triple=riscv32 -mattr=+m -filetype=obj" LD=ld.lld ./build.sh
+AS=${AS:-"llvm-mc -triple=riscv32 -mattr=+m -filetype=obj"}
+LD=${LD:-ld.lld}
+
+cd "$(dirname "$0")"
+
+for SOURCE in rv32im fib matmul crc32 sort sieve timer irq
+do
+    $AS -o $SOURCE.o $SOURCE.S || exit 1
+    $LD -T link.ld -o $SOURCE.elf $SOURCE.o || exit 1
+    rm $SOURCE.o
+done
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2017 Matthias Jung
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BUS_H
+#define BUS_H
+
+#include <vector>
+#include <systemc.h>
+#include <tlm.h>
+#include <tlm_utils/multi_passthrough_initiator_socket.h>
+#include <tlm_utils/multi_passthrough_target_socket.h>
+
+// Loosely timed interconnect between several cores and one shared memory.
+// Every transfer is annotated with the latency of the bus, debug accesses
+// are forwarded without delay. Further targets, e.g. the CLINT, are bound
+// to the initiator socket after the memory and get a region with map().
+class bus : sc_module
+{
+    public:
+    tlm_utils::multi_passthrough_target_socket<bus> tSocket;
+    tlm_utils::multi_passthrough_initiator_socket<bus> iSocket;
+
+    bus(sc_module_name name, sc_time latency = sc_time(1, SC_NS)) :
+        sc_module(name),
+        tSocket("tSocket"),
+        iSocket("iSocket"),
+        latency(latency)
+    {
+        tSocket.register_b_transport(this, &bus::b_transport);
+        tSocket.register_transport_dbg(this, &bus::transport_dbg);
+    }
+
+    // Transfers to [base, base + size) go to the target with the given
+    // binding index, with the address relative to base. All other transfers
+    // go to the memory, the first target:
+    void map(unsigned int target, uint64_t base, uint64_t size)
+    {
+        regions.push_back({target, base, size});
+    }
+
+    private:
+    struct region
+    {
+        unsigned int target;
+        uint64_t base;
+        uint64_t size;
+    };
+
+    sc_time latency;
+    std::vector<region> regions;
+
+    // Target of the address, which becomes relative to its region:
+    unsigned int decode(uint64_t &address) const
+    {
+        for(const region &r : regions)
+        {
+            if(address - r.base < r.size)
+            {
+                address -= r.base;
+                return r.target;
+            }
+        }
+        return 0;
+    }
+
+    void b_transport(int id, tlm::tlm_generic_payload &trans, sc_time &delay)
+    {
+        uint64_t address = trans.get_address();
+        uint64_t local = address;
+        unsigned int target = decode(local);
+
+        delay += latency;
+        trans.set_address(local);
+        iSocket[target]->b_transport(trans, delay);
+        trans.set_address(address);
+    }
+
+    unsigned int transport_dbg(int id, tlm::tlm_generic_payload &trans)
+    {
+        uint64_t address = trans.get_address();
+        uint64_t local = address;
+        unsigned int target = decode(local);
+
+        trans.set_address(local);
+        unsigned int n = iSocket[target]->transport_dbg(trans);
+        trans.set_address(address);
+        return n;
+    }
+};
+
+#endif // BUS_H
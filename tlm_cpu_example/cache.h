@@ -0,0 +1,456 @@
+/*
+ * Copyright 2017 Matthias Jung
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <systemc.h>
+#include <tlm.h>
+#include <tlm_utils/multi_passthrough_target_socket.h>
+#include <tlm_utils/simple_initiator_socket.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Write-back, write-allocate cache between initiators and a memory. The
+// geometry and the replacement policy are configurable, refills and write
+// backs are single burst transactions of a whole line. The cache holds the
+// data, debug accesses see the contents of dirty lines, and DMI is denied
+// so that every access goes through the cache.
+//
+// The tags are kept as structure of arrays: the tags of one set are
+// contiguous and compared four at a time with SSE2, the dirty flags and
+// replacement stamps live in separate arrays. Statistics are kept per
+// initiator of the target socket, i.e. per core if every core is bound to
+// the cache directly.
+class cache : sc_module
+{
+    public:
+    enum policy
+    {
+        lru,
+        fifo,
+        random
+    };
+
+    struct config
+    {
+        unsigned int size;          // Bytes
+        unsigned int associativity;
+        unsigned int lineSize;      // Bytes
+        policy replacement;
+        sc_time hitLatency;
+    };
+
+    struct statistics
+    {
+        uint64_t reads;
+        uint64_t readMisses;
+        uint64_t writes;
+        uint64_t writeMisses;
+        uint64_t writebacks;
+    };
+
+    tlm_utils::multi_passthrough_target_socket<cache> tSocket;
+    tlm_utils::simple_initiator_socket<cache> iSocket;
+
+    cache(sc_module_name name, const config &c) :
+        sc_module(name),
+        tSocket("tSocket"),
+        iSocket("iSocket"),
+        cfg(c),
+        clock(0),
+        seed(0x2545f491)
+    {
+        ways = cfg.associativity;
+        sets = ways && cfg.lineSize ? cfg.size / (ways * cfg.lineSize) : 0;
+
+        if(!power(cfg.lineSize) || cfg.lineSize < 4 || !power(sets)
+           || ways == 0 || sets * ways * cfg.lineSize != cfg.size)
+        {
+            SC_REPORT_FATAL(this->name(), "Invalid cache geometry");
+        }
+
+        offsetBits = log2(cfg.lineSize);
+        indexBits = log2(sets);
+
+        tags.assign(sets * ways, invalid);
+        dirty.assign(sets * ways, 0);
+        stamps.assign(sets * ways, 0);
+        data.assign(size_t(sets) * ways * cfg.lineSize, 0);
+
+        tSocket.register_b_transport(this, &cache::b_transport);
+        tSocket.register_transport_dbg(this, &cache::transport_dbg);
+        tSocket.register_get_direct_mem_ptr(this, &cache::get_direct_mem_ptr);
+    }
+
+    const statistics& getStatistics(unsigned int initiator)
+    {
+        return stats(initiator);
+    }
+
+    void report(std::ostream &os = std::cout) const
+    {
+        static const char *policies[] = {"lru", "fifo", "random"};
+
+        os << std::endl << "Cache " << name() << ": "
+           << cfg.size / 1024 << " KiB, " << ways << " way, "
+           << cfg.lineSize << " byte lines, "
+           << policies[cfg.replacement] << std::endl
+           << std::left << std::setw(12) << "initiator" << std::right
+           << std::setw(14) << "reads"
+           << std::setw(14) << "read misses"
+           << std::setw(14) << "writes"
+           << std::setw(14) << "write misses"
+           << std::setw(14) << "writebacks"
+           << std::setw(10) << "miss %" << std::endl;
+
+        for(unsigned int i = 0; i < statistic.size(); i++)
+        {
+            const statistics &s = statistic[i];
+            uint64_t accesses = s.reads + s.writes;
+            uint64_t misses = s.readMisses + s.writeMisses;
+            std::streamsize precision = os.precision();
+
+            os << std::left << std::setw(12) << i << std::right
+               << std::setw(14) << s.reads
+               << std::setw(14) << s.readMisses
+               << std::setw(14) << s.writes
+               << std::setw(14) << s.writeMisses
+               << std::setw(14) << s.writebacks
+               << std::setw(10) << std::fixed << std::setprecision(2)
+               << (accesses ? 100.0 * misses / accesses : 0.0)
+               << std::defaultfloat << std::setprecision(precision)
+               << std::endl;
+        }
+    }
+
+    private:
+    enum : uint32_t { invalid = 0xffffffff };
+
+    config cfg;
+    unsigned int ways;
+    unsigned int sets;
+    unsigned int offsetBits;
+    unsigned int indexBits;
+    uint64_t clock;
+    uint32_t seed;
+
+    std::vector<uint32_t> tags;
+    std::vector<uint8_t> dirty;
+    std::vector<uint64_t> stamps;
+    std::vector<unsigned char> data;
+    std::vector<statistics> statistic;
+
+    static bool power(unsigned int x)
+    {
+        return x != 0 && (x & (x - 1)) == 0;
+    }
+
+    static unsigned int log2(unsigned int x)
+    {
+        unsigned int n = 0;
+        while(x >>= 1)
+        {
+            n++;
+        }
+        return n;
+    }
+
+    statistics& stats(unsigned int initiator)
+    {
+        if(initiator >= statistic.size())
+        {
+            statistic.resize(initiator + 1, statistics());
+        }
+        return statistic[initiator];
+    }
+
+    uint32_t setOf(uint64_t address) const
+    {
+        return (address >> offsetBits) & (sets - 1);
+    }
+
+    uint32_t tagOf(uint64_t address) const
+    {
+        return address >> (offsetBits + indexBits);
+    }
+
+    uint64_t addressOf(uint32_t set, uint32_t tag) const
+    {
+        return ((uint64_t(tag) << indexBits) | set) << offsetBits;
+    }
+
+    unsigned char* line(uint32_t set, unsigned int way)
+    {
+        return &data[(size_t(set) * ways + way) * cfg.lineSize];
+    }
+
+    // Way of the set that holds the tag, or -1:
+    int find(uint32_t set, uint32_t tag) const
+    {
+        const uint32_t *t = &tags[set * ways];
+        unsigned int w = 0;
+
+#ifdef __SSE2__
+        __m128i key = _mm_set1_epi32(tag);
+        for(; w + 4 <= ways; w += 4)
+        {
+            __m128i v = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(t + w));
+            int mask = _mm_movemask_ps(
+                _mm_castsi128_ps(_mm_cmpeq_epi32(v, key)));
+            if(mask)
+            {
+                return w + __builtin_ctz(mask);
+            }
+        }
+#endif
+
+        for(; w < ways; w++)
+        {
+            if(t[w] == tag)
+            {
+                return w;
+            }
+        }
+        return -1;
+    }
+
+    unsigned int victim(uint32_t set)
+    {
+        unsigned int first = set * ways;
+
+        for(unsigned int w = 0; w < ways; w++)
+        {
+            if(tags[first + w] == invalid)
+            {
+                return w;
+            }
+        }
+
+        if(cfg.replacement == random)
+        {
+            // xorshift32:
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            return seed % ways;
+        }
+
+        // Oldest access (LRU) or oldest refill (FIFO):
+        return std::min_element(stamps.begin() + first,
+                                stamps.begin() + first + ways)
+               - (stamps.begin() + first);
+    }
+
+    bool burst(tlm::tlm_command cmd,
+               uint64_t address,
+               unsigned char *ptr,
+               sc_time &delay)
+    {
+        tlm::tlm_generic_payload trans;
+        trans.set_command(cmd);
+        trans.set_address(address);
+        trans.set_data_ptr(ptr);
+        trans.set_data_length(cfg.lineSize);
+        trans.set_streaming_width(cfg.lineSize);
+        trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+
+        iSocket->b_transport(trans, delay);
+
+        return trans.is_response_ok();
+    }
+
+    // Line that holds the address, refilled on a miss. Returns nullptr if
+    // the memory cannot refill the line.
+    unsigned char* access(uint64_t address,
+                          bool write,
+                          statistics &s,
+                          sc_time &delay)
+    {
+        uint32_t set = setOf(address);
+        uint32_t tag = tagOf(address);
+        int way = find(set, tag);
+
+        if(write)
+        {
+            s.writes++;
+        }
+        else
+        {
+            s.reads++;
+        }
+
+        if(way < 0)
+        {
+            if(write)
+            {
+                s.writeMisses++;
+            }
+            else
+            {
+                s.readMisses++;
+            }
+
+            way = victim(set);
+            unsigned int i = set * ways + way;
+
+            if(tags[i] != invalid && dirty[i])
+            {
+                s.writebacks++;
+                burst(tlm::TLM_WRITE_COMMAND, addressOf(set, tags[i]),
+                      line(set, way), delay);
+            }
+
+            tags[i] = invalid;
+            dirty[i] = 0;
+
+            if(!burst(tlm::TLM_READ_COMMAND,
+                      address & ~uint64_t(cfg.lineSize - 1),
+                      line(set, way), delay))
+            {
+                return nullptr;
+            }
+
+            tags[i] = tag;
+            stamps[i] = ++clock;
+        }
+        else if(cfg.replacement == lru)
+        {
+            stamps[set * ways + way] = ++clock;
+        }
+
+        if(write)
+        {
+            dirty[set * ways + way] = 1;
+        }
+
+        return line(set, way);
+    }
+
+    void b_transport(int id, tlm::tlm_generic_payload &trans, sc_time &delay)
+    {
+        statistics &s = stats(id);
+        uint64_t address = trans.get_address();
+        unsigned char *ptr = trans.get_data_ptr();
+        unsigned int length = trans.get_data_length();
+        bool write = trans.is_write();
+
+        delay += cfg.hitLatency;
+
+        // Accesses that cross a line boundary are split:
+        while(length > 0)
+        {
+            unsigned int offset = address & (cfg.lineSize - 1);
+            unsigned int n = std::min(length, cfg.lineSize - offset);
+            unsigned char *l = access(address, write, s, delay);
+
+            if(l == nullptr)
+            {
+                trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+                return;
+            }
+
+            if(write)
+            {
+                memcpy(l + offset, ptr, n);
+            }
+            else
+            {
+                memcpy(ptr, l + offset, n);
+            }
+
+            address += n;
+            ptr += n;
+            length -= n;
+        }
+
+        trans.set_response_status(tlm::TLM_OK_RESPONSE);
+    }
+
+    // Debug accesses go to the memory, the cached lines are kept coherent:
+    // reads see the data of the cache, writes update it.
+    unsigned int transport_dbg(int id, tlm::tlm_generic_payload &trans)
+    {
+        unsigned int n = iSocket->transport_dbg(trans);
+        uint64_t start = trans.get_address();
+        uint64_t end = start + n;
+        unsigned char *ptr = trans.get_data_ptr();
+
+        for(uint64_t a = start & ~uint64_t(cfg.lineSize - 1); a < end;
+            a += cfg.lineSize)
+        {
+            uint32_t set = setOf(a);
+            int way = find(set, tagOf(a));
+            if(way < 0)
+            {
+                continue;
+            }
+
+            uint64_t first = std::max(a, start);
+            uint64_t last = std::min<uint64_t>(a + cfg.lineSize, end);
+            unsigned char *l = line(set, way) + (first - a);
+
+            if(trans.is_write())
+            {
+                memcpy(l, ptr + (first - start), last - first);
+            }
+            else
+            {
+                memcpy(ptr + (first - start), l, last - first);
+            }
+        }
+
+        return n;
+    }
+
+    bool get_direct_mem_ptr(int id,
+                            tlm::tlm_generic_payload &trans,
+                            tlm::tlm_dmi &dmi)
+    {
+        return false;
+    }
+
+    void end_of_simulation()
+    {
+        report();
+    }
+};
+
+#endif // CACHE_H
@@ -0,0 +1,244 @@
+/*
+ * Copyright 2017 Matthias Jung
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Architectural state of an RV32IM cpu:
+struct cpu_state
+{
+    uint64_t time;          // Local time of the cpu in units of resolution
+    uint64_t resolution;    // SystemC time resolution of the writer in fs
+    uint64_t instructions;  // Executed instructions
+    uint32_t nopCounter;
+    uint32_t pc;
+    int32_t reg[32];
+};
+
+// Binary checkpoint file (host byte order), all offsets are multiples of
+// the page size, so that the pages can be used directly from an mmap of
+// the file:
+//
+//   header pages: u32 magic, u32 version, u32 page size, u32 #pages,
+//                 u64 memory size, cpu_state,
+//                 u32 page number for each stored page
+//   data pages:   contents of the stored pages
+//
+// Pages that contain only zeros are not stored.
+namespace checkpoint
+{
+    const uint32_t magic = 0x31565254; // "TRV1"
+    const uint32_t version = 2;
+    const uint32_t pageSize = 4096;
+
+    struct header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t pageSize;
+        uint32_t pages;
+        uint64_t memorySize;
+        cpu_state state;
+    };
+
+    // Number of pages occupied by the header and the page table:
+    inline size_t headerPages(size_t pages)
+    {
+        return (sizeof(header) + pages * sizeof(uint32_t) + pageSize - 1)
+               / pageSize;
+    }
+
+    inline bool zero(const unsigned char *page, size_t size)
+    {
+        for(size_t i = 0; i < size; i++)
+        {
+            if(page[i] != 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    inline bool write(const std::string &file,
+                      const cpu_state &state,
+                      const std::vector<unsigned char> &memory)
+    {
+        std::vector<uint32_t> table;
+        for(size_t p = 0; p * pageSize < memory.size(); p++)
+        {
+            size_t size = std::min<size_t>(pageSize,
+                                           memory.size() - p * pageSize);
+            if(!zero(&memory[p * pageSize], size))
+            {
+                table.push_back(p);
+            }
+        }
+
+        std::vector<unsigned char> first(headerPages(table.size()) * pageSize);
+        header h;
+        h.magic = magic;
+        h.version = version;
+        h.pageSize = pageSize;
+        h.pages = table.size();
+        h.memorySize = memory.size();
+        h.state = state;
+        memcpy(&first[0], &h, sizeof(h));
+        if(!table.empty())
+        {
+            memcpy(&first[sizeof(h)], &table[0],
+                   table.size() * sizeof(uint32_t));
+        }
+
+        std::ofstream out(file, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(&first[0]), first.size());
+
+        std::vector<unsigned char> page(pageSize);
+        for(uint32_t p : table)
+        {
+            size_t size = std::min<size_t>(pageSize,
+                                           memory.size() - p * pageSize);
+            std::fill(page.begin(), page.end(), 0);
+            memcpy(&page[0], &memory[p * pageSize], size);
+            out.write(reinterpret_cast<const char*>(&page[0]), pageSize);
+        }
+
+        return bool(out);
+    }
+
+    // Maps a checkpoint file into memory, the pages are not copied
+    class reader
+    {
+        public:
+        reader(const std::string &file) : data(nullptr), size(0)
+        {
+            int fd = open(file.c_str(), O_RDONLY);
+            if(fd < 0)
+            {
+                return;
+            }
+
+            struct stat s;
+            if(fstat(fd, &s) == 0 && s.st_size >= (off_t)pageSize)
+            {
+                void *m = mmap(nullptr, s.st_size, PROT_READ, MAP_PRIVATE,
+                               fd, 0);
+                if(m != MAP_FAILED)
+                {
+                    data = static_cast<const unsigned char*>(m);
+                    size = s.st_size;
+                }
+            }
+            close(fd);
+
+            if(data && !valid())
+            {
+                munmap(const_cast<unsigned char*>(data), size);
+                data = nullptr;
+            }
+        }
+
+        ~reader()
+        {
+            if(data)
+            {
+                munmap(const_cast<unsigned char*>(data), size);
+            }
+        }
+
+        bool ok() const
+        {
+            return data != nullptr;
+        }
+
+        const header& head() const
+        {
+            return *reinterpret_cast<const header*>(data);
+        }
+
+        uint32_t pages() const
+        {
+            return head().pages;
+        }
+
+        // Page number and contents of the i-th stored page:
+        uint32_t number(uint32_t i) const
+        {
+            return table()[i];
+        }
+
+        const unsigned char* page(uint32_t i) const
+        {
+            return data + (headerPages(pages()) + i) * pageSize;
+        }
+
+        private:
+        const unsigned char *data;
+        size_t size;
+
+        const uint32_t* table() const
+        {
+            return reinterpret_cast<const uint32_t*>(data + sizeof(header));
+        }
+
+        bool valid() const
+        {
+            const header &h = head();
+            if(h.magic != magic || h.version != version
+               || h.pageSize != pageSize || h.state.resolution == 0
+               || size < (headerPages(h.pages) + h.pages) * pageSize)
+            {
+                return false;
+            }
+            for(uint32_t i = 0; i < h.pages; i++)
+            {
+                if(size_t(number(i)) * pageSize >= h.memorySize)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+}
+
+#endif // CHECKPOINT_H
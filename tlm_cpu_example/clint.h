@@ -0,0 +1,217 @@
+/*
+ * Copyright 2017 Matthias Jung
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CLINT_H
+#define CLINT_H
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <systemc.h>
+#include <tlm.h>
+#include <tlm_utils/multi_passthrough_target_socket.h>
+
+#include "interrupts.h"
+
+// Core local interruptor with the register layout of the RISC-V CLINT,
+// addresses are relative to the region the bus maps it to:
+//
+//   0x0000 + 4 * hart  msip      software interrupt of the hart, bit 0
+//   0x4000 + 8 * hart  mtimecmp  timer compare value of the hart
+//   0xbff8             mtime     timer, read only
+//
+// The timer is not clocked. mtime is computed from the SystemC time plus
+// the annotated delay of the access, i.e. from the local time of a
+// temporally decoupled hart. A write of mtimecmp hands the absolute time at
+// which mtime reaches it to the hart, see interruptible.
+class clint : sc_module
+{
+    public:
+    // Every hart may reach the CLINT through a decoder of its own:
+    tlm_utils::multi_passthrough_target_socket<clint> tSocket;
+
+    // Region of the CLINT in the memory map of the platform:
+    enum : uint64_t
+    {
+        base = 0x02000000,
+        size = 0x10000
+    };
+
+    clint(sc_module_name name, sc_time tick = sc_time(100, SC_NS)) :
+        sc_module(name),
+        tSocket("tSocket"),
+        tick(tick)
+    {
+        tSocket.register_b_transport(this, &clint::b_transport);
+        tSocket.register_transport_dbg(this, &clint::transport_dbg);
+    }
+
+    // The harts are numbered in the order they are attached:
+    unsigned int attach(interruptible &hart)
+    {
+        harts.push_back(&hart);
+        mtimecmp.push_back(UINT64_MAX);
+        msip.push_back(0);
+        return harts.size() - 1;
+    }
+
+    private:
+    void b_transport(int id, tlm::tlm_generic_payload &trans, sc_time &delay)
+    {
+        delay += sc_time(1, SC_NS);
+
+        trans.set_response_status(access(trans, sc_time_stamp() + delay)
+                                  ? tlm::TLM_OK_RESPONSE
+                                  : tlm::TLM_ADDRESS_ERROR_RESPONSE);
+    }
+
+    // The registers have side effects, so there is no DMI callback:
+    unsigned int transport_dbg(int id, tlm::tlm_generic_payload& trans)
+    {
+        return access(trans, sc_time_stamp()) ? trans.get_data_length() : 0;
+    }
+
+    enum : uint64_t
+    {
+        msipOffset = 0x0000,
+        mtimecmpOffset = 0x4000,
+        mtimeOffset = 0xbff8
+    };
+
+    sc_time tick;
+    std::vector<interruptible*> harts;
+    std::vector<uint64_t> mtimecmp;
+    std::vector<uint32_t> msip;
+
+    // Naturally aligned accesses of 4 or 8 bytes, a 4 byte access is a
+    // read-modify-write of the half of the 64 bit word it addresses:
+    bool access(tlm::tlm_generic_payload &trans, const sc_time &now)
+    {
+        uint64_t address = trans.get_address();
+        unsigned int length = trans.get_data_length();
+
+        if((length != 4 && length != 8) || address % length != 0)
+        {
+            return false;
+        }
+
+        uint64_t word = address & ~uint64_t(7);
+        unsigned int shift = (address & 7) * 8;
+        uint64_t value = 0;
+
+        if(!read(word, now, value))
+        {
+            return false;
+        }
+
+        if(trans.is_read())
+        {
+            value >>= shift;
+            memcpy(trans.get_data_ptr(), &value, length);
+        }
+        else if(trans.is_write())
+        {
+            uint64_t data = 0;
+            uint64_t mask = (length == 8 ? UINT64_MAX : 0xffffffffu);
+            memcpy(&data, trans.get_data_ptr(), length);
+            value = (value & ~(mask << shift)) | (data << shift);
+            write(word, value);
+        }
+
+        return true;
+    }
+
+    bool read(uint64_t word, const sc_time &now, uint64_t &value) const
+    {
+        if(word == mtimeOffset)
+        {
+            value = now.value() / tick.value();
+            return true;
+        }
+        if(word >= mtimecmpOffset
+           && word < mtimecmpOffset + 8 * harts.size())
+        {
+            value = mtimecmp[(word - mtimecmpOffset) / 8];
+            return true;
+        }
+        if(word < msipOffset + 4 * harts.size())
+        {
+            unsigned int hart = (word - msipOffset) / 4;
+            value = msip[hart];
+            if(hart + 1 < harts.size())
+            {
+                value |= uint64_t(msip[hart + 1]) << 32;
+            }
+            return true;
+        }
+        return false;
+    }
+
+    void write(uint64_t word, uint64_t value)
+    {
+        if(word >= mtimecmpOffset
+           && word < mtimecmpOffset + 8 * harts.size())
+        {
+            unsigned int hart = (word - mtimecmpOffset) / 8;
+            mtimecmp[hart] = value;
+            harts[hart]->setTimer(deadline(value));
+        }
+        else if(word < msipOffset + 4 * harts.size())
+        {
+            unsigned int hart = (word - msipOffset) / 4;
+            setSoftware(hart, value & 1);
+            if(hart + 1 < harts.size())
+            {
+                setSoftware(hart + 1, (value >> 32) & 1);
+            }
+        }
+    }
+
+    void setSoftware(unsigned int hart, uint32_t pending)
+    {
+        if(msip[hart] != pending)
+        {
+            msip[hart] = pending;
+            harts[hart]->setSoftware(pending);
+        }
+    }
+
+    // Time at which mtime reaches the compare value:
+    sc_time deadline(uint64_t compare) const
+    {
+        if(compare > sc_max_time().value() / tick.value())
+        {
+            return sc_max_time();
+        }
+        return sc_time::from_value(compare * tick.value());
+    }
+};
+
+#endif // CLINT_H
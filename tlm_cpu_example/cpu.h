@@ -34,23 +34,42 @@
 #ifndef CPU_H
 #define CPU_H
 
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
+#include <cstdint>
+#include <vector>
 #include <systemc.h>
 #include <tlm.h>
+#include <tlm_utils/tlm_quantumkeeper.h>
+
+#include "../delta_profiler/process_profiler.h"
+#include "checkpoint.h"
+#include "instruction_profiler.h"
+#include "interrupts.h"
+#include "isa.h"
+#include "loader.h"
+#include "parallel_executor.h"
+#include "translator.h"
 
 //#define DEBUG
 
+// Register file of the cpu. Writes to x0 are legal and are redirected
+// without a branch to a write sink behind x31, so x0 always reads as zero.
+// The index checks are sc_asserts, which compile out with NDEBUG, i.e. in
+// release builds. The registers start on a cache line of their own.
 class registers
 {
     private:
-    int32_t reg[32];
+    enum : uint32_t { sink = 32 };
+
+    alignas(64) int32_t reg[sink + 1];
     uint32_t pc;
 
     public:
     registers()
     {
-        for(int i = 0; i < 32; i++ )
+        for(uint32_t i = 0; i <= sink; i++)
         {
             reg[i] = 0;
         }
@@ -59,24 +78,35 @@ class registers
 
     void set(uint32_t n, int32_t data)
     {
-        sc_assert(n > 0 && n < 32);
-        reg[n] = data;
+        sc_assert(n < 32);
+        reg[n | (uint32_t(n == 0) << 5)] = data;
     }
 
-    int32_t get(uint32_t n)
+    int32_t get(uint32_t n) const
     {
-        sc_assert(n >= 0 && n < 32);
+        sc_assert(n < 32);
         return reg[n];
     }
 
-    uint32_t getPc()
+    // Bulk copies of x0 .. x31, e.g. for the translator:
+    void load(int32_t *x) const
+    {
+        memcpy(x, reg, 32 * sizeof(int32_t));
+    }
+
+    void store(const int32_t *x)
+    {
+        memcpy(reg, x, 32 * sizeof(int32_t));
+        reg[0] = 0;
+    }
+
+    uint32_t getPc() const
     {
         return pc;
     }
 
     void setPc(uint32_t val)
     {
-        sc_assert(val >= 0);
         pc = val;
     }
 
@@ -84,74 +114,279 @@ class registers
     {
         pc += 4;
     }
-};
 
-// TinyRV1
-// - ADD, ADDI, MUL
-// - LW, SW
-// - JAL, JR
-// - BNE
+    void save(cpu_state &state) const
+    {
+        load(state.reg);
+        state.pc = pc;
+    }
 
-enum CMD
-{
-    nop,
-    add,
-    addi,
-    mul,
-    lw,
-    sw,
-    jal,
-    jr,
-    bne
+    void restore(const cpu_state &state)
+    {
+        store(state.reg);
+        pc = state.pc;
+    }
 };
 
-enum OPCODE : uint32_t
+// Quantum keeper of one cpu. With a quantum of its own the cpu
+// synchronizes at the multiples of that quantum, otherwise at the
+// multiples of the global quantum:
+class cpu_quantumkeeper : public tlm_utils::tlm_quantumkeeper
 {
-    op_add  = 0b0110011,
-    op_addi = 0b0010011,
-    op_mul  = 0b0110011,
-    op_lw   = 0b0000011,
-    op_sw   = 0b0100011,
-    op_jal  = 0b1101111,
-    op_jr   = 0b1100111,
-    op_bne  = 0b1100011
-};
+    public:
+    cpu_quantumkeeper() : quantum(SC_ZERO_TIME)
+    {
+    }
 
-enum FUNCT3 : uint32_t
-{
-    f3_add  = 0b000,
-    f3_addi = 0b000,
-    f3_mul  = 0b000,
-    f3_lw   = 0b010,
-    f3_sw   = 0b010,
-    f3_jr   = 0b000,
-    f3_bne  = 0b001
-};
+    // Zero selects the global quantum:
+    void setQuantum(const sc_time &q)
+    {
+        quantum = q;
+    }
 
-enum FUNCT7 : uint32_t
-{
-    f7_add = 0b0000000,
-    f7_mul = 0b0000001,
+    sc_time getQuantum() const
+    {
+        return quantum == SC_ZERO_TIME ? get_global_quantum() : quantum;
+    }
+
+    protected:
+    sc_time compute_local_quantum()
+    {
+        sc_time q = getQuantum();
+        if(q == SC_ZERO_TIME)
+        {
+            return SC_ZERO_TIME;
+        }
+        return q - sc_time::from_value(sc_time_stamp().value() % q.value());
+    }
+
+    private:
+    sc_time quantum;
 };
 
-class cpu: sc_module, tlm::tlm_bw_transport_if<>
+class cpu: sc_module, tlm::tlm_bw_transport_if<>, public parallel_core,
+           public interruptible
 {
+    friend class translator<cpu>;
+
     public:
     tlm::tlm_initiator_socket<> iSocket;
     SC_CTOR(cpu) : iSocket("iSocket"),
                    cycleTime(sc_time(1, SC_NS)),
-                   nopCounter(0)
+                   nopCounter(0),
+                   instructions(0),
+                   image(nullptr),
+                   verbose(true),
+                   halted(false),
+                   exitCode(0),
+                   useDmi(false),
+                   dmiValid(false),
+                   executor(nullptr),
+                   onWorker(false),
+                   ahead(SC_ZERO_TIME),
+                   local(SC_ZERO_TIME),
+                   end(SC_ZERO_TIME),
+                   translation(*this, cycleTime),
+                   useTranslation(false),
+                   blockStart(true),
+                   profiler(nullptr),
+                   profiled(nullptr),
+                   recording(false),
+                   mstatus(0),
+                   mie(0),
+                   mtvec(0),
+                   mscratch(0),
+                   mepc(0),
+                   mcause(0),
+                   hartId(0),
+                   softwarePending(false),
+                   externalPending(false),
+                   timerDeadline(sc_max_time()),
+                   nextInterrupt(sc_max_time()),
+                   checkpointAfter(0),
+                   checkpointSize(0)
     {
         iSocket.bind(*this);
         SC_THREAD(process);
+        running()++;
+    }
+
+    // Entry point and symbols of the program:
+    void setProgram(const program_image &program)
+    {
+        image = &program;
+    }
+
+    void setVerbose(bool v)
+    {
+        verbose = v;
+    }
+
+    uint64_t getInstructions() const
+    {
+        return instructions;
+    }
+
+    // Value of a0 at the exit system call:
+    int32_t getExitCode() const
+    {
+        return exitCode;
+    }
+
+    // Several cores run temporally decoupled: every core executes up to one
+    // global quantum ahead of the SystemC time before it synchronizes. The
+    // memory is shared, so stores of one core become visible to the other
+    // cores at the latest at the next quantum boundary, or immediately if
+    // both cores execute a FENCE. The default quantum of zero synchronizes
+    // after every instruction.
+    static void setQuantum(const sc_time &quantum)
+    {
+        tlm_utils::tlm_quantumkeeper::set_global_quantum(quantum);
+    }
+
+    // Quantum of this cpu instead of the global quantum, e.g. a short one
+    // for a core that polls the others and a long one for a core that only
+    // computes. On the threads of a parallel_executor all cores use the
+    // quantum of the executor:
+    void setCpuQuantum(const sc_time &quantum)
+    {
+        quantumKeeper.setQuantum(quantum);
+    }
+
+    // Fetches, loads and stores use a DMI pointer of the target if it grants
+    // one:
+    void setDmi(bool dmi)
+    {
+        useDmi = dmi;
+    }
+
+    // Hot basic blocks are translated and executed by the translator:
+    void setTranslation(bool t)
+    {
+        useTranslation = t;
+    }
+
+    // Counts the executed instructions and memory accesses of the guest:
+    void setProfiler(instruction_profiler *p)
+    {
+        profiler = p;
+    }
+
+    // Value of mhartid, e.g. the index of the cpu at the CLINT:
+    void setHartId(uint32_t id)
+    {
+        hartId = id;
+    }
+
+    void setTimer(const sc_time &deadline)
+    {
+        timerDeadline = deadline;
+        updateInterrupts();
+    }
+
+    void setSoftware(bool pending)
+    {
+        softwarePending = pending;
+        updateInterrupts();
+    }
+
+    void setExternal(bool pending)
+    {
+        externalPending = pending;
+        updateInterrupts();
+    }
+
+    // The quantum bodies of the cpu are executed by the executor instead of
+    // the SC_THREAD of the cpu:
+    void setExecutor(parallel_executor *e)
+    {
+        executor = e;
+        executor->add(this);
+    }
+
+    void boot()
+    {
+        if(restoreFile.empty())
+        {
+            initialize();
+        }
+        else
+        {
+            restore();
+        }
+
+        if(image && profiler)
+        {
+            image->symbols(
+                [this](const char *name, uint32_t address, uint32_t size)
+                {
+                    profiler->symbol(name, address, size);
+                });
+        }
+
+        if(useDmi)
+        {
+            acquireDmi();
+        }
+
+        translation.flush();
+        blockStart = true;
+
+        quantumKeeper.reset();
+    }
+
+    // Runs on a worker thread of the executor. The cpu executes until its
+    // local time reaches the quantum, the time of the last instruction that
+    // crosses the quantum boundary is carried over to the next quantum.
+    // FENCE needs no synchronization here, since every quantum ends at a
+    // barrier of all cores.
+    void runQuantum(const sc_time &quantum)
+    {
+        local = ahead;
+        end = quantum;
+        onWorker = true;
+
+        while(!halted && local < quantum)
+        {
+            if(blockStart && interruptDue())
+            {
+                interrupt();
+            }
+
+            sc_time delay = SC_ZERO_TIME;
+            advance(delay, quantum - local);
+            local += delay;
+        }
+
+        onWorker = false;
+        ahead = halted ? SC_ZERO_TIME : local - quantum;
+    }
+
+    bool isHalted() const
+    {
+        return halted;
+    }
+
+    // Writes a checkpoint with the first size bytes of the memory after
+    // the given number of instructions:
+    void saveCheckpoint(const std::string &file, uint64_t after, size_t size)
+    {
+        checkpointFile = file;
+        checkpointAfter = after;
+        checkpointSize = size;
+    }
+
+    // Starts from a checkpoint instead of booting the program:
+    void restoreCheckpoint(const std::string &file)
+    {
+        restoreFile = file;
     }
 
 
-    // Dummy method:
     void invalidate_direct_mem_ptr(sc_dt::uint64 start_range,
                                    sc_dt::uint64 end_range)
     {
-        SC_REPORT_FATAL(this->name(),"invalidate_direct_mem_ptr not implement");
+        dmiValid = false;
     }
 
     // Dummy method:
@@ -169,6 +404,140 @@ class cpu: sc_module, tlm::tlm_bw_transport_if<>
     registers r;
     sc_time cycleTime;
     uint8_t nopCounter;
+    uint64_t instructions;
+    const program_image *image;
+    bool verbose;
+    bool halted;
+    int32_t exitCode;
+    cpu_quantumkeeper quantumKeeper;
+
+    bool useDmi;
+    bool dmiValid;
+    tlm::tlm_dmi dmi;
+
+    parallel_executor *executor;
+    bool onWorker;
+    sc_time ahead;
+    sc_time local;
+    sc_time end;
+
+    translator<cpu> translation;
+    bool useTranslation;
+    bool blockStart;
+
+    instruction_profiler *profiler;
+    instruction_profiler::block *profiled; // Block of the interpreter
+    bool recording;                        // First execution of profiled
+
+    // Machine mode interrupt state. nextInterrupt is the earliest time at
+    // which an enabled interrupt is pending, it is recomputed whenever the
+    // CSRs or the interrupt inputs change:
+    uint32_t mstatus;
+    uint32_t mie;
+    uint32_t mtvec;
+    uint32_t mscratch;
+    uint32_t mepc;
+    uint32_t mcause;
+    uint32_t hartId;
+    bool softwarePending;
+    bool externalPending;
+    sc_time timerDeadline;
+    sc_time nextInterrupt;
+
+    std::string checkpointFile;
+    uint64_t checkpointAfter;
+    size_t checkpointSize;
+    std::string restoreFile;
+
+    void save()
+    {
+        cpu_state state;
+        state.time = quantumKeeper.get_current_time().value();
+        state.resolution = resolution();
+        state.instructions = instructions;
+        state.nopCounter = nopCounter;
+        r.save(state);
+
+        // Read the memory page by page, a target that is smaller than the
+        // given size ends the checkpoint early:
+        std::vector<unsigned char> memory(checkpointSize);
+        tlm::tlm_generic_payload trans;
+        trans.set_read();
+
+        for(size_t offset = 0; offset < memory.size();)
+        {
+            unsigned int length = std::min<size_t>(checkpoint::pageSize,
+                                                   memory.size() - offset);
+            trans.set_address(offset);
+            trans.set_data_ptr(&memory[offset]);
+            trans.set_data_length(length);
+
+            unsigned int n = iSocket->transport_dbg(trans);
+            offset += n;
+
+            if(n < length)
+            {
+                memory.resize(offset);
+            }
+        }
+
+        if(!checkpoint::write(checkpointFile, state, memory))
+        {
+            SC_REPORT_FATAL(name(), "Cannot write checkpoint");
+        }
+
+        std::cout << "@" << sc_time_stamp() << " checkpoint after "
+                  << instructions << " instructions written to "
+                  << checkpointFile << std::endl;
+    }
+
+    void restore()
+    {
+        checkpoint::reader in(restoreFile);
+
+        if(!in.ok())
+        {
+            SC_REPORT_FATAL(name(), "Cannot read checkpoint");
+        }
+
+        const checkpoint::header &h = in.head();
+        tlm::tlm_generic_payload trans;
+        trans.set_write();
+
+        for(uint32_t i = 0; i < in.pages(); i++)
+        {
+            uint64_t address = uint64_t(in.number(i)) * checkpoint::pageSize;
+            unsigned int size = std::min<uint64_t>(checkpoint::pageSize,
+                                                   h.memorySize - address);
+            trans.set_address(address);
+            trans.set_data_length(size);
+            trans.set_data_ptr(const_cast<unsigned char*>(in.page(i)));
+
+            if(iSocket->transport_dbg(trans) != size)
+            {
+                SC_REPORT_FATAL(name(), "Checkpoint exceeds memory");
+            }
+        }
+
+        r.restore(h.state);
+        nopCounter = h.state.nopCounter;
+        instructions = h.state.instructions;
+
+        // Continue at the local time of the checkpoint, also if it was
+        // written with another time resolution. The resolutions are powers
+        // of ten fs:
+        uint64_t now = resolution();
+        uint64_t time = h.state.resolution >= now
+                      ? h.state.time * (h.state.resolution / now)
+                      : h.state.time / (now / h.state.resolution);
+        profiled_wait(sc_time::from_value(time) - sc_time_stamp());
+    }
+
+    // Time resolution of the simulation in fs:
+    static uint64_t resolution()
+    {
+        return uint64_t(sc_get_time_resolution().to_seconds() * 1e15 + 0.5);
+    }
 
     void dumpMemory(unsigned int size)
     {
@@ -216,68 +585,66 @@ class cpu: sc_module, tlm::tlm_bw_transport_if<>
         }
     }
 
+    // The image itself is installed in the memory by the platform, see
+    // mem::load():
     void initialize()
     {
-        FILE * file;
-        long size;
-        unsigned char * buffer;
-        size_t result;
-
-        file = fopen ("test.asm.bin" , "rb");
-
-        if (file == NULL)
+        if(image)
         {
-            SC_REPORT_FATAL(name(), "Cannot load program file");
+            r.setPc(image->entry());
         }
-
-        // Obtain file size:
-        fseek (file , 0 , SEEK_END);
-        size = ftell (file);
-        rewind (file);
-
-        // Allocate memory to contain the whole file:
-        buffer = (unsigned char*) malloc (sizeof(unsigned char)*size);
-        if (buffer == NULL)
-        {
-            SC_REPORT_FATAL(name(), "Malloc error");
-        }
-
-        // Copy the file into the buffer:
-        result = fread (buffer, 1, size, file);
-        if (result != size)
-        {
-            SC_REPORT_FATAL(name(), "Reading error");
-        }
-
-        tlm::tlm_generic_payload trans;
-        trans.set_address(0);
-        trans.set_write();
-        trans.set_data_length(size);
-        trans.set_data_ptr(buffer);
-
-        unsigned int n = iSocket->transport_dbg(trans);
-
-        sc_assert(n == size);
-
-        // terminate
-        fclose(file);
-        free(buffer);
     }
 
     void do_b_transport(uint64_t addr,
                        tlm::tlm_command cmd,
                        unsigned char * ptr,
+                       unsigned int length,
                        sc_time &delay)
     {
+        if(dmiValid
+           && addr >= dmi.get_start_address()
+           && addr + length - 1 <= dmi.get_end_address())
+        {
+            unsigned char *p = dmi.get_dmi_ptr()
+                             + (addr - dmi.get_start_address());
+
+            if(cmd == tlm::TLM_WRITE_COMMAND && dmi.is_write_allowed())
+            {
+                memcpy(p, ptr, length);
+                delay += dmi.get_write_latency();
+                return;
+            }
+            else if(cmd == tlm::TLM_READ_COMMAND && dmi.is_read_allowed())
+            {
+                memcpy(ptr, p, length);
+                delay += dmi.get_read_latency();
+                return;
+            }
+        }
+
         tlm::tlm_generic_payload trans;
         trans.set_address(addr);
-        trans.set_data_length(4);
-        trans.set_streaming_width(4);
+        trans.set_data_length(length);
+        trans.set_streaming_width(length);
         trans.set_command(cmd);
         trans.set_data_ptr(ptr);
         trans.set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
 
-        iSocket->b_transport(trans, delay);
+        // The annotated delay includes the local time offset of the cpu, so
+        // that targets like the CLINT see the time of the access:
+        sc_time offset = onWorker ? local : quantumKeeper.get_local_time();
+        delay += offset;
+
+        if(onWorker)
+        {
+            executor->transport(iSocket.get_interface(), trans, delay);
+        }
+        else
+        {
+            iSocket->b_transport(trans, delay);
+        }
+
+        delay -= offset;
 
         if (trans.is_response_error())
         {
@@ -285,276 +652,688 @@ class cpu: sc_module, tlm::tlm_bw_transport_if<>
         }
     }
 
+    void acquireDmi()
+    {
+        tlm::tlm_generic_payload trans;
+        trans.set_address(0);
+        trans.set_read();
+        dmiValid = iSocket->get_direct_mem_ptr(trans, dmi);
+    }
+
     void process()
     {
+        if(executor)
+        {
+            return;
+        }
+
+        process_profiler::enter();
+
         //wait();
-        initialize();
+        boot();
 
-        while(1)
+        while(!halted)
         {
-            sc_time delay = SC_ZERO_TIME;
+            if(checkpointAfter && instructions >= checkpointAfter)
+            {
+                save();
+                checkpointAfter = 0;
+            }
 
-            uint32_t inst = 0;
+            if(blockStart && interruptDue())
+            {
+                interrupt();
+            }
 
-            delay += fetch(inst);
+            sc_time delay = SC_ZERO_TIME;
+            bool sync = advance(delay, remaining());
 
-            CMD cmd = decode(inst);
+            quantumKeeper.inc(delay);
 
-            delay += execute_writeback(cmd, inst);
+            if(quantumKeeper.need_sync() || sync)
+            {
+                process_profiler::leave(true);
+                quantumKeeper.sync();
+                process_profiler::enter();
+            }
+        }
 
-            wait(delay);
+        // The simulation ends when the last core has halted:
+        if(--running() == 0)
+        {
+            sc_stop();
         }
     }
 
-    sc_time fetch(uint32_t &data)
+    // Executes a translated block chain if the pc is the start of a hot
+    // block, otherwise a single instruction. Returns true after a FENCE.
+    bool advance(sc_time &delay, const sc_time &budget)
     {
-        sc_time delay = sc_time(0, SC_NS);
+        if(useTranslation && blockStart && !checkpointAfter)
+        {
+            // Translated code also stops at the next interrupt:
+            sc_time limit = budget;
+            if(nextInterrupt != sc_max_time())
+            {
+                sc_time current = now();
+                if(nextInterrupt > current && nextInterrupt - current < limit)
+                {
+                    limit = nextInterrupt - current;
+                }
+            }
 
-        do_b_transport(r.getPc(),
-                       tlm::TLM_READ_COMMAND,
-                       reinterpret_cast<unsigned char*>(&data),
-                       delay);
+            uint64_t n = translation.run(delay, limit);
+            if(n > 0)
+            {
+                instructions += n;
+                return false;
+            }
+        }
 
-        return delay;
+        CMD cmd = step(delay);
+        blockStart = endsBlock(cmd);
+
+        // Fold the block counts into the profile:
+        if(halted)
+        {
+            translation.flush();
+        }
+
+        return cmd == fence;
     }
 
-    CMD decode(uint32_t &data)
+    // Time until the next quantum boundary, translated code stops at the
+    // first block that reaches it:
+    sc_time remaining()
     {
-        // Get opcode:
-        uint32_t opcode = (data & 0b00000000000000000000000001111111);
-        uint32_t funct3 = (data & 0b00000000000000000111000000000000) >> 12;
-        uint32_t funct7 = (data & 0b11111110000000000000000000000000) >> 25;
+        sc_time quantum = quantumKeeper.getQuantum();
 
-        if (data == 0)
-        {
-            return nop;
-        }
-        else if(opcode == op_add && funct3 == f3_add && funct7 == f7_add)
+        if(quantum == SC_ZERO_TIME)
         {
-            return add;
+            return SC_ZERO_TIME;
         }
-        else if(opcode == op_addi && funct3 == f3_addi)
-        {
-            return addi;
-        }
-        else if(opcode == op_mul && funct3 == f3_mul && funct7 == f7_mul)
-        {
-            return mul;
-        }
-        else if(opcode == op_lw && funct3 == f3_lw)
+
+        sc_dt::uint64 now = quantumKeeper.get_current_time().value();
+        return sc_time::from_value(quantum.value()
+                                   - now % quantum.value());
+    }
+
+    // Local time of the cpu, on a worker relative to the quantum that the
+    // SystemC thread of the executor waits for:
+    sc_time now() const
+    {
+        return onWorker ? sc_time_stamp() + local
+                        : quantumKeeper.get_current_time();
+    }
+
+    // Checked at block boundaries, without enabled interrupts this is a
+    // single comparison:
+    bool interruptDue() const
+    {
+        return nextInterrupt != sc_max_time() && nextInterrupt <= now();
+    }
+
+    uint32_t pendingInterrupts() const
+    {
+        return (softwarePending ? mip_msip : 0)
+             | (now() >= timerDeadline ? mip_mtip : 0)
+             | (externalPending ? mip_meip : 0);
+    }
+
+    void updateInterrupts()
+    {
+        nextInterrupt = sc_max_time();
+
+        if(!(mstatus & mstatus_mie))
         {
-            return lw;
+            return;
         }
-        else if(opcode == op_sw && funct3 == f3_sw)
+
+        if(((mie & mip_msip) && softwarePending)
+           || ((mie & mip_meip) && externalPending))
         {
-            return sw;
+            nextInterrupt = SC_ZERO_TIME;
         }
-        else if(opcode == op_jal)
+        else if(mie & mip_mtip)
         {
-            return jal;
+            nextInterrupt = timerDeadline;
         }
-        else if(opcode == op_jr && funct3 == f3_jr)
+    }
+
+    // Traps to mtvec with the highest priority pending interrupt, external
+    // before software before timer. Only called at block boundaries, once
+    // the time of the next interrupt has been reached:
+    void interrupt()
+    {
+        uint32_t pending = pendingInterrupts() & mie;
+
+        if(!(mstatus & mstatus_mie) || pending == 0)
         {
-            return jr;
+            return;
         }
-        else if(opcode == op_bne && funct3 == f3_bne)
+
+        uint32_t cause = (pending & mip_meip) ? 11
+                       : (pending & mip_msip) ? 3
+                       : 7;
+
+        mepc = r.getPc();
+        mcause = 0x80000000 | cause;
+        mstatus = (mstatus & mstatus_mie) ? mstatus_mpie : 0;
+
+        // Direct or vectored mode:
+        r.setPc((mtvec & ~3u) + ((mtvec & 1) ? 4 * cause : 0));
+
+        updateInterrupts();
+    }
+
+    uint32_t readCsr(uint32_t number)
+    {
+        switch(number)
         {
-            return bne;
+            case csr_mstatus:  return mstatus;
+            case csr_mie:      return mie;
+            case csr_mtvec:    return mtvec;
+            case csr_mscratch: return mscratch;
+            case csr_mepc:     return mepc;
+            case csr_mcause:   return mcause;
+            case csr_mip:      return pendingInterrupts();
+            case csr_mhartid:  return hartId;
         }
-        else
+
+        SC_REPORT_FATAL(name(), "CSR not supported");
+        return 0;
+    }
+
+    // mip and mhartid are read only, their pending bits come from the
+    // interrupt inputs:
+    void writeCsr(uint32_t number, uint32_t value)
+    {
+        switch(number)
         {
-            SC_REPORT_FATAL(name(), "Instruction not supported by TinyRV1");
+            case csr_mstatus:
+                mstatus = value & (mstatus_mie | mstatus_mpie);
+                break;
+            case csr_mie:
+                mie = value & (mip_msip | mip_mtip | mip_meip);
+                break;
+            case csr_mtvec:    mtvec = value & ~2u; break;
+            case csr_mscratch: mscratch = value; break;
+            case csr_mepc:     mepc = value & ~3u; break;
+            case csr_mcause:   mcause = value; break;
+            case csr_mip:      break;
+            case csr_mhartid:  break;
+            default:
+                SC_REPORT_FATAL(name(), "CSR not supported");
         }
+
+        updateInterrupts();
     }
 
-    sc_time execute_writeback(CMD cmd, uint32_t &data)
+    // Time until the next synchronization, on a worker until the end of the
+    // quantum of the executor:
+    sc_time untilSync()
     {
-        // Extract registers and immediates common for all instructions:
-        sc_time delay = SC_ZERO_TIME;
+        return onWorker ? end - local : remaining();
+    }
 
-        uint32_t rs2 = (data & 0b00000001111100000000000000000000) >> 20;
-        uint32_t rs1 = (data & 0b00000000000011111000000000000000) >> 15;
-        uint32_t rd  = (data & 0b00000000000000000000111110000000) >> 7;
+    CMD step(sc_time &delay)
+    {
+        uint32_t inst = 0;
+        uint32_t pc = r.getPc();
 
-        // Immediate sign extension (imm may be overwritten by specific instr.):
-        int32_t imm  = (((int32_t)data)
-                             & 0b11111111111100000000000000000000) >> 20;
+        delay += fetch(pc, inst);
 
-        bool sign = (data & 0b10000000000000000000000000000000) >> 31;
+        CMD cmd = decode(inst);
 
-        if(sign == true)
-        {
-            imm = imm | 0b11111111111111111111000000000000;
-        }
+        delay += execute_writeback(cmd, inst);
+        instructions++;
 
-        // Execute instructions
-        if(cmd == nop)
+        if(profiler)
         {
-            nopCounter++;
-            if(nopCounter > 10)
-            {
-                dumpRegisters();
-                sc_stop();
-            }
-
-            r.incrementPc();
-            return cycleTime;
+            profile(pc, cmd, r.getPc());
         }
-        else if(cmd == add)
-        {
-            r.set(rd, r.get(rs1) + r.get(rs2));
 
-            #ifdef DEBUG
-            cout << "@" << sc_time_stamp() << " ";
-            cout << "x" << rd << " = x" << rs1 << " + x" << rs2 << endl;
-            #endif
+        return cmd;
+    }
 
-            r.incrementPc();
-            return cycleTime;
-        }
-        else if (cmd == addi)
-        {
-            r.set(rd, r.get(rs1) + imm);
+    static unsigned int& running()
+    {
+        static unsigned int cores = 0;
+        return cores;
+    }
 
-            #ifdef DEBUG
-            cout << "@" << sc_time_stamp() << " ";
-            cout << "x" << rd << " = x" << rs1 << " + " << imm << endl;
-            #endif
+    sc_time fetch(uint32_t address, uint32_t &data)
+    {
+        sc_time delay = SC_ZERO_TIME;
 
-            r.incrementPc();
-            return cycleTime;
-        }
-        else if(cmd == mul)
-        {
-            r.set(rd, r.get(rs1) * r.get(rs2));
+        do_b_transport(address,
+                       tlm::TLM_READ_COMMAND,
+                       reinterpret_cast<unsigned char*>(&data),
+                       4,
+                       delay);
+
+        return delay;
+    }
 
-            #ifdef DEBUG
-            cout << "@" << sc_time_stamp() << " ";
-            cout << "x" << rd << " = x" << rs1 << " * x" << rs2 << endl;
-            #endif
+    CMD decode(uint32_t &data)
+    {
+        // Get opcode:
+        uint32_t opcode = (data & 0b00000000000000000000000001111111);
+        uint32_t funct3 = (data & 0b00000000000000000111000000000000) >> 12;
+        uint32_t funct7 = (data & 0b11111110000000000000000000000000) >> 25;
 
-            r.incrementPc();
-            return cycleTime;
+        if (data == 0)
+        {
+            return nop;
         }
-        else if(cmd == lw)
+
+        switch(opcode)
         {
-            int32_t word  = 0;
-            uint64_t addr = r.get(rs1)+imm;
+            case op_lui:
+                return lui;
+            case op_auipc:
+                return auipc;
+            case op_jal:
+                return jal;
+            case op_jalr:
+                if(funct3 == f3_jalr)
+                {
+                    return jalr;
+                }
+                break;
+            case op_branch:
+                switch(funct3)
+                {
+                    case f3_beq:  return beq;
+                    case f3_bne:  return bne;
+                    case f3_blt:  return blt;
+                    case f3_bge:  return bge;
+                    case f3_bltu: return bltu;
+                    case f3_bgeu: return bgeu;
+                }
+                break;
+            case op_load:
+                switch(funct3)
+                {
+                    case f3_lb:  return lb;
+                    case f3_lh:  return lh;
+                    case f3_lw:  return lw;
+                    case f3_lbu: return lbu;
+                    case f3_lhu: return lhu;
+                }
+                break;
+            case op_store:
+                switch(funct3)
+                {
+                    case f3_sb: return sb;
+                    case f3_sh: return sh;
+                    case f3_sw: return sw;
+                }
+                break;
+            case op_imm:
+                switch(funct3)
+                {
+                    case f3_add:  return addi;
+                    case f3_slt:  return slti;
+                    case f3_sltu: return sltiu;
+                    case f3_xor:  return xori;
+                    case f3_or:   return ori;
+                    case f3_and:  return andi;
+                    case f3_sll:
+                        if(funct7 == f7_add) return slli;
+                        break;
+                    case f3_srl:
+                        if(funct7 == f7_add) return srli;
+                        if(funct7 == f7_sub) return srai;
+                        break;
+                }
+                break;
+            case op_reg:
+                if(funct7 == f7_add)
+                {
+                    switch(funct3)
+                    {
+                        case f3_add:  return add;
+                        case f3_sll:  return sll;
+                        case f3_slt:  return slt;
+                        case f3_sltu: return sltu;
+                        case f3_xor:  return xor_;
+                        case f3_srl:  return srl;
+                        case f3_or:   return or_;
+                        case f3_and:  return and_;
+                    }
+                }
+                else if(funct7 == f7_sub)
+                {
+                    if(funct3 == f3_add) return sub;
+                    if(funct3 == f3_srl) return sra;
+                }
+                else if(funct7 == f7_mul)
+                {
+                    switch(funct3)
+                    {
+                        case f3_add:  return mul;
+                        case f3_sll:  return mulh;
+                        case f3_slt:  return mulhsu;
+                        case f3_sltu: return mulhu;
+                        case f3_xor:  return div_;
+                        case f3_srl:  return divu;
+                        case f3_or:   return rem;
+                        case f3_and:  return remu;
+                    }
+                }
+                break;
+            case op_fence:
+                if(funct3 == f3_fence || funct3 == f3_fencei)
+                {
+                    return fence;
+                }
+                break;
+            case op_system:
+                switch(funct3)
+                {
+                    case f3_csrrw:  return csrrw;
+                    case f3_csrrs:  return csrrs;
+                    case f3_csrrc:  return csrrc;
+                    case f3_csrrwi: return csrrwi;
+                    case f3_csrrsi: return csrrsi;
+                    case f3_csrrci: return csrrci;
+                }
+                if(data == 0b00000000000000000000000001110011)
+                {
+                    return ecall;
+                }
+                if(data == 0b00000000000100000000000001110011)
+                {
+                    return ebreak;
+                }
+                if(data == 0b00110000001000000000000001110011)
+                {
+                    return mret;
+                }
+                if(data == 0b00010000010100000000000001110011)
+                {
+                    return wfi;
+                }
+                break;
+        }
 
-            do_b_transport(addr,
-                           tlm::TLM_READ_COMMAND,
-                           reinterpret_cast<unsigned char*>(&word),
-                           delay);
+        SC_REPORT_FATAL(name(), "Instruction not supported by RV32IM");
+        return nop;
+    }
 
-            r.set(rd, word);
+    // Writes to x0 end in the write sink of the register file:
+    void writeback(uint32_t rd, int32_t value)
+    {
+        r.set(rd, value);
+    }
 
-            #ifdef DEBUG
-            cout << "@" << sc_time_stamp() << " LW:";
-            cout << "x" << rd << " = 0x" << hex << addr
-                 << dec << "("<< word << ")" << endl;
-            #endif
+    template <class T>
+    T load(uint32_t addr, sc_time &delay)
+    {
+        T value = 0;
 
-            r.incrementPc();
-            return delay;
-        }
-        else if(cmd == sw)
+        if(profiler)
         {
-            uint32_t im1 = (data & 0b11111110000000000000000000000000) >> 25;
-            uint32_t im2 = (data & 0b00000000000000000000111110000000) >> 7;
-
-            // Sign extension:
-            bool sign = (data & 0b10000000000000000000000000000000) >> 31;
+            profiler->load(addr);
+        }
 
-            if(sign == false)
-            {
-                imm = im2 | (im1 << 5);
-            }
-            else
-            {
-                imm = im2 | (im1 << 5) | 0b11111111111111111111000000000000;
-            }
+        do_b_transport(addr,
+                       tlm::TLM_READ_COMMAND,
+                       reinterpret_cast<unsigned char*>(&value),
+                       sizeof(T),
+                       delay);
+        return value;
+    }
 
-            int32_t word  = r.get(rs2);
-            sc_time delay = SC_ZERO_TIME;
-            uint64_t addr = r.get(rs1)+imm;
+    template <class T>
+    void store(uint32_t addr, T value, sc_time &delay)
+    {
+        if(profiler)
+        {
+            profiler->store(addr);
+        }
 
-            do_b_transport(addr,
-                           tlm::TLM_WRITE_COMMAND,
-                           reinterpret_cast<unsigned char*>(&word),
-                           delay);
+        do_b_transport(addr,
+                       tlm::TLM_WRITE_COMMAND,
+                       reinterpret_cast<unsigned char*>(&value),
+                       sizeof(T),
+                       delay);
 
-            #ifdef DEBUG
-            cout << "@" << sc_time_stamp() << " SW:";
-            cout << "0x" << hex << addr << dec << " = " << word << endl;
-            #endif
+        // Self-modifying code invalidates the translations:
+        translation.written(addr, sizeof(T));
+    }
 
-            r.incrementPc();
-            return delay;
-        }
-        else if(cmd == jr)
+    // Counts per basic block, like the translator. The instructions of a
+    // block are reported once, at its first execution. Code that is
+    // modified afterwards keeps the commands and the length of its block
+    // in the profile:
+    void profile(uint32_t pc, CMD cmd, uint32_t next)
+    {
+        if(blockStart)
         {
-            #ifdef DEBUG
-            cout << "@" << sc_time_stamp() << " ";
-            cout << "jr " << r.get(rs1) << endl;
-            #endif
-
-            r.setPc(r.get(rs1));
-            return cycleTime;
+            profiled = &profiler->entered(pc);
+            recording = profiled->count++ == 0;
         }
-        else if(cmd == jal)
-        {
-            imm = (data & 0b11111111111111111111000000000000) >> 12;
 
-            bool sign = (data & 0b10000000000000000000000000000000) >> 31;
+        if(recording)
+        {
+            profiler->executed(pc, cmd, 0);
+            profiled->last = pc;
+        }
 
-            if(sign == true)
-            {
-                imm = imm | 0b11111111111100000000000000000000;
-            }
+        if(next != pc + 4)
+        {
+            profiled->taken++;
+        }
+    }
 
-            #ifdef DEBUG
-            cout << "@" << sc_time_stamp() << " ";
-            cout << "jal " << r.get(rs1) << endl;
-            #endif
+    sc_time execute_writeback(CMD cmd, uint32_t &data)
+    {
+        // Extract registers common for all instructions:
+        sc_time delay = SC_ZERO_TIME;
 
-            r.set(rd,r.getPc()+4);
-            r.setPc(r.getPc()+imm);
-            return cycleTime;
-        }
-        else if(cmd == bne)
-        {
-            uint32_t im1 = (data & 0b11111110000000000000000000000000) >> 25;
-            uint32_t im2 = (data & 0b00000000000000000000111110000000) >> 7;
+        uint32_t rs2 = (data & 0b00000001111100000000000000000000) >> 20;
+        uint32_t rs1 = (data & 0b00000000000011111000000000000000) >> 15;
+        uint32_t rd  = (data & 0b00000000000000000000111110000000) >> 7;
 
-            // Sign extension:
-            bool sign = (data & 0b10000000000000000000000000000000) >> 31;
+        int32_t a = r.get(rs1);
+        int32_t b = r.get(rs2);
+        uint32_t ua = a;
+        uint32_t ub = b;
+        uint32_t pc = r.getPc();
+        uint32_t next = pc + 4;
 
-            if(sign == false)
-            {
-                imm = im2 | (im1 << 5);
-            }
-            else
-            {
-                imm = im2 | (im1 << 5) | 0b11111111111111111111000000000000;
-            }
+        #ifdef DEBUG
+        cout << "@" << sc_time_stamp() << " " << hex << pc << ": "
+             << std::setw(8) << std::setfill('0') << data << dec << endl;
+        #endif
 
-            if(r.get(rs1) != r.get(rs2))
+        // Execute instructions
+        switch(cmd)
+        {
+            case nop:
+                nopCounter++;
+                if(nopCounter > 10)
+                {
+                    if(verbose)
+                    {
+                        dumpRegisters();
+                    }
+                    halted = true;
+                }
+                break;
+
+            case lui:   writeback(rd, immU(data)); break;
+            case auipc: writeback(rd, pc + immU(data)); break;
+
+            case jal:
+                writeback(rd, pc + 4);
+                next = pc + immJ(data);
+                break;
+            case jalr:
+                next = (a + immI(data)) & ~1u;
+                writeback(rd, pc + 4);
+                break;
+
+            case beq:  if(a == b)   next = pc + immB(data); break;
+            case bne:  if(a != b)   next = pc + immB(data); break;
+            case blt:  if(a < b)    next = pc + immB(data); break;
+            case bge:  if(a >= b)   next = pc + immB(data); break;
+            case bltu: if(ua < ub)  next = pc + immB(data); break;
+            case bgeu: if(ua >= ub) next = pc + immB(data); break;
+
+            case lb:  writeback(rd, load<int8_t>(a + immI(data), delay)); break;
+            case lh:  writeback(rd, load<int16_t>(a + immI(data), delay)); break;
+            case lw:  writeback(rd, load<int32_t>(a + immI(data), delay)); break;
+            case lbu: writeback(rd, load<uint8_t>(a + immI(data), delay)); break;
+            case lhu: writeback(rd, load<uint16_t>(a + immI(data), delay)); break;
+
+            case sb: store<uint8_t>(a + immS(data), b, delay); break;
+            case sh: store<uint16_t>(a + immS(data), b, delay); break;
+            case sw: store<uint32_t>(a + immS(data), b, delay); break;
+
+            case addi:  writeback(rd, a + immI(data)); break;
+            case slti:  writeback(rd, a < immI(data)); break;
+            case sltiu: writeback(rd, ua < (uint32_t)immI(data)); break;
+            case xori:  writeback(rd, a ^ immI(data)); break;
+            case ori:   writeback(rd, a | immI(data)); break;
+            case andi:  writeback(rd, a & immI(data)); break;
+            case slli:  writeback(rd, ua << rs2); break;
+            case srli:  writeback(rd, ua >> rs2); break;
+            case srai:  writeback(rd, a >> rs2); break;
+
+            case add:  writeback(rd, ua + ub); break;
+            case sub:  writeback(rd, ua - ub); break;
+            case sll:  writeback(rd, ua << (ub & 31)); break;
+            case slt:  writeback(rd, a < b); break;
+            case sltu: writeback(rd, ua < ub); break;
+            case xor_: writeback(rd, a ^ b); break;
+            case srl:  writeback(rd, ua >> (ub & 31)); break;
+            case sra:  writeback(rd, a >> (ub & 31)); break;
+            case or_:  writeback(rd, a | b); break;
+            case and_: writeback(rd, a & b); break;
+
+            case mul:
+                writeback(rd, ua * ub);
+                break;
+            case mulh:
+                writeback(rd, ((int64_t)a * (int64_t)b) >> 32);
+                break;
+            case mulhsu:
+                writeback(rd, ((int64_t)a * (int64_t)ub) >> 32);
+                break;
+            case mulhu:
+                writeback(rd, ((uint64_t)ua * (uint64_t)ub) >> 32);
+                break;
+            case div_:
+                if(b == 0)
+                {
+                    writeback(rd, -1);
+                }
+                else if(a == INT32_MIN && b == -1)
+                {
+                    writeback(rd, a);
+                }
+                else
+                {
+                    writeback(rd, a / b);
+                }
+                break;
+            case divu:
+                writeback(rd, ub == 0 ? 0xffffffff : ua / ub);
+                break;
+            case rem:
+                if(b == 0)
+                {
+                    writeback(rd, a);
+                }
+                else if(a == INT32_MIN && b == -1)
+                {
+                    writeback(rd, 0);
+                }
+                else
+                {
+                    writeback(rd, a % b);
+                }
+                break;
+            case remu:
+                writeback(rd, ub == 0 ? ua : ua % ub);
+                break;
+
+            case fence:
+                // The quantum keeper is synchronized by process()
+                break;
+
+            case ecall:
+                // Only the exit system call is supported:
+                if(r.get(17) == 93)
+                {
+                    exitCode = r.get(10);
+                    halted = true;
+                }
+                break;
+            case ebreak:
+                halted = true;
+                break;
+
+            case csrrw:
+            case csrrs:
+            case csrrc:
+            case csrrwi:
+            case csrrsi:
+            case csrrci:
             {
-                r.setPc(r.getPc() + imm);
+                // The immediate forms take rs1 as zero extended value:
+                uint32_t number = data >> 20;
+                bool immediate = cmd == csrrwi || cmd == csrrsi
+                                 || cmd == csrrci;
+                uint32_t operand = immediate ? rs1 : ua;
+                uint32_t old = readCsr(number);
+
+                if(cmd == csrrw || cmd == csrrwi)
+                {
+                    writeCsr(number, operand);
+                }
+                else if(rs1 != 0)
+                {
+                    writeCsr(number, (cmd == csrrs || cmd == csrrsi)
+                                     ? old | operand : old & ~operand);
+                }
+                writeback(rd, old);
+                break;
             }
-            else
+            case mret:
+                next = mepc;
+                mstatus = mstatus_mpie
+                        | ((mstatus & mstatus_mpie) ? mstatus_mie : 0);
+                updateInterrupts();
+                break;
+            case wfi:
             {
-                r.incrementPc();
+                // Sleeps until the next interrupt, but at most until the
+                // next quantum boundary, where the cpu synchronizes and
+                // sees changed interrupt inputs. Without a quantum WFI is a
+                // nop:
+                sc_time current = now();
+                sc_time sleep = untilSync();
+                if(nextInterrupt <= current)
+                {
+                    sleep = SC_ZERO_TIME;
+                }
+                else if(nextInterrupt - current < sleep)
+                {
+                    sleep = nextInterrupt - current;
+                }
+                delay = sleep;
+                break;
             }
-
-            #ifdef DEBUG
-            cout << "@" << sc_time_stamp() << " ";
-            cout << "bne " << r.getPc() << endl;
-            #endif
-
-            return delay;
         }
 
+        r.setPc(next);
+
+        // Loads and stores take the time of the memory access:
+        return delay == SC_ZERO_TIME ? cycleTime : delay;
     }
 
 };
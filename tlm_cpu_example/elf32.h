@@ -0,0 +1,229 @@
+/*
+ * Copyright 2017 Matthias Jung
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ELF32_H
+#define ELF32_H
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+
+// Minimal reader for statically linked little endian ELF32 RISC-V
+// executables, as produced by riscv32-unknown-elf-gcc or llvm-mc/ld.lld.
+namespace elf32
+{
+    struct header
+    {
+        unsigned char ident[16];
+        uint16_t type;
+        uint16_t machine;
+        uint32_t version;
+        uint32_t entry;
+        uint32_t phoff;
+        uint32_t shoff;
+        uint32_t flags;
+        uint16_t ehsize;
+        uint16_t phentsize;
+        uint16_t phnum;
+        uint16_t shentsize;
+        uint16_t shnum;
+        uint16_t shstrndx;
+    };
+
+    struct program_header
+    {
+        uint32_t type;
+        uint32_t offset;
+        uint32_t vaddr;
+        uint32_t paddr;
+        uint32_t filesz;
+        uint32_t memsz;
+        uint32_t flags;
+        uint32_t align;
+    };
+
+    struct section_header
+    {
+        uint32_t name;
+        uint32_t type;
+        uint32_t flags;
+        uint32_t addr;
+        uint32_t offset;
+        uint32_t size;
+        uint32_t link;
+        uint32_t info;
+        uint32_t addralign;
+        uint32_t entsize;
+    };
+
+    struct symbol
+    {
+        uint32_t name;
+        uint32_t value;
+        uint32_t size;
+        unsigned char info;
+        unsigned char other;
+        uint16_t shndx;
+    };
+
+    const uint16_t executable = 2;
+    const uint16_t riscv = 243;
+    const uint32_t load = 1;
+    const uint32_t symtab = 2;
+
+    inline bool is_elf(const unsigned char *image, size_t size)
+    {
+        return size >= 4 && memcmp(image, "\x7f" "ELF", 4) == 0;
+    }
+
+    // Calls segment(address, data, filesz, memsz) for every loadable
+    // segment, the bytes between filesz and memsz must be zeroed by the
+    // caller. Returns false if the image is not a valid RV32 executable.
+    inline bool load_segments(
+        const unsigned char *image,
+        size_t size,
+        uint32_t &entry,
+        const std::function<void(uint32_t, const unsigned char*,
+                                 uint32_t, uint32_t)> &segment)
+    {
+        if(size < sizeof(header) || !is_elf(image, size))
+        {
+            return false;
+        }
+
+        header h;
+        memcpy(&h, image, sizeof(h));
+
+        // 32 bit, little endian, RISC-V executable:
+        if(h.ident[4] != 1 || h.ident[5] != 1
+           || h.type != executable || h.machine != riscv
+           || h.phentsize != sizeof(program_header)
+           || h.phoff + uint64_t(h.phnum) * sizeof(program_header) > size)
+        {
+            return false;
+        }
+
+        for(unsigned int i = 0; i < h.phnum; i++)
+        {
+            program_header p;
+            memcpy(&p, image + h.phoff + i * sizeof(program_header),
+                   sizeof(p));
+
+            if(p.type != load)
+            {
+                continue;
+            }
+            if(uint64_t(p.offset) + p.filesz > size || p.filesz > p.memsz)
+            {
+                return false;
+            }
+            segment(p.paddr, image + p.offset, p.filesz, p.memsz);
+        }
+
+        entry = h.entry;
+        return true;
+    }
+
+    // Calls sym(name, address, size) for every defined function, object or
+    // label of the symbol table. Returns false if there is no symbol table.
+    inline bool load_symbols(
+        const unsigned char *image,
+        size_t size,
+        const std::function<void(const char*, uint32_t, uint32_t)> &sym)
+    {
+        if(size < sizeof(header) || !is_elf(image, size))
+        {
+            return false;
+        }
+
+        header h;
+        memcpy(&h, image, sizeof(h));
+
+        if(h.shentsize != sizeof(section_header)
+           || h.shoff + uint64_t(h.shnum) * sizeof(section_header) > size)
+        {
+            return false;
+        }
+
+        for(unsigned int i = 0; i < h.shnum; i++)
+        {
+            section_header s;
+            memcpy(&s, image + h.shoff + i * sizeof(section_header),
+                   sizeof(s));
+
+            if(s.type != symtab || s.link >= h.shnum
+               || uint64_t(s.offset) + s.size > size)
+            {
+                continue;
+            }
+
+            section_header strings;
+            memcpy(&strings,
+                   image + h.shoff + s.link * sizeof(section_header),
+                   sizeof(strings));
+            if(uint64_t(strings.offset) + strings.size > size)
+            {
+                return false;
+            }
+            const char *names = reinterpret_cast<const char*>(image)
+                              + strings.offset;
+
+            for(uint32_t o = 0; o + sizeof(symbol) <= s.size;
+                o += sizeof(symbol))
+            {
+                symbol e;
+                memcpy(&e, image + s.offset + o, sizeof(e));
+
+                // NOTYPE (labels), OBJECT and FUNC of a section, without
+                // undefined and absolute symbols:
+                unsigned int type = e.info & 0xf;
+                if(type > 2 || e.shndx == 0 || e.shndx >= 0xff00
+                   || e.name == 0
+                   || e.name >= strings.size
+                   || memchr(names + e.name, 0, strings.size - e.name)
+                      == nullptr)
+                {
+                    continue;
+                }
+
+                // Temporary labels of the assembler:
+                if(strncmp(names + e.name, ".L", 2) == 0)
+                {
+                    continue;
+                }
+                sym(names + e.name, e.value, e.size);
+            }
+            return true;
+        }
+        return false;
+    }
+}
+
+#endif // ELF32_H
@@ -0,0 +1,522 @@
+/*
+ * Copyright 2017 Matthias Jung
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef INSTRUCTION_PROFILER_H
+#define INSTRUCTION_PROFILER_H
+
+#include <systemc.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "isa.h"
+
+// Counting profiler for the guest program of one cpu. The cpu reports
+// the addresses of all loads and stores. Executed instructions and taken
+// control transfers are counted per basic block: the interpreter counts
+// its blocks here and reports the instructions of a block once, with
+// their commands, when the block is entered for the first time. These
+// blocks are folded into the profile at end_of_simulation, translated
+// blocks when the translations are flushed. Then a binary profile is
+// written and a report is printed, which is symbolized with the symbols
+// of the ELF executable.
+//
+// Binary profile (host byte order):
+//
+//   header:  u32 magic, u32 version, u32 bucket bits, u32 #sites,
+//            u32 #load buckets, u32 #store buckets,
+//            u64 executed instructions for every CMD
+//   sites:   u32 pc, u32 CMD, u64 count, u64 taken
+//   buckets: u32 address, u32 reserved, u64 count (loads, then stores)
+SC_MODULE(instruction_profiler)
+{
+    public:
+    // Counters indexed by a 32 bit number, allocated page by page on first
+    // use. The last used page is cached, so that counting in a loop costs
+    // a compare and an add.
+    template <class T>
+    class counters
+    {
+        public:
+        // No page has the number none, so the first use looks the page up:
+        counters() : lastNumber(none), last(nullptr)
+        {
+        }
+
+        T& operator[](uint32_t index)
+        {
+            uint32_t number = index >> pageBits;
+            if(number != lastNumber)
+            {
+                std::vector<T> &p = pages[number];
+                if(p.empty())
+                {
+                    p.resize(pageSize, T());
+                }
+                last = p.data();
+                lastNumber = number;
+            }
+            return last[index & (pageSize - 1)];
+        }
+
+        void clear()
+        {
+            pages.clear();
+            lastNumber = none;
+            last = nullptr;
+        }
+
+        // Calls f(index, counter) in ascending order of the index for all
+        // counters that are used:
+        template <class F>
+        void forEach(F f) const
+        {
+            for(auto &p : pages)
+            {
+                for(uint32_t i = 0; i < pageSize; i++)
+                {
+                    if(!(p.second[i] == T()))
+                    {
+                        f((p.first << pageBits) | i, p.second[i]);
+                    }
+                }
+            }
+        }
+
+        private:
+        enum : uint32_t { pageBits = 10, pageSize = 1 << pageBits,
+                          none = ~0u };
+        std::map<uint32_t, std::vector<T>> pages;
+        uint32_t lastNumber;
+        T *last;
+
+        counters(const counters&) = delete;
+        counters& operator=(const counters&) = delete;
+    };
+
+    struct site
+    {
+        uint64_t count;
+        uint64_t taken;
+        uint32_t cmd;
+
+        bool operator==(const site &s) const
+        {
+            return count == s.count && taken == s.taken;
+        }
+    };
+
+    // Basic block of the interpreter, keyed by the pc of its first
+    // instruction. Blocks end at the first instruction for which
+    // endsBlock() holds, so unless the code is modified, the block of a pc
+    // always has the same last instruction:
+    struct block
+    {
+        uint64_t count;
+        uint64_t taken;
+        uint32_t last;
+
+        bool operator==(const block &b) const
+        {
+            return count == b.count;
+        }
+    };
+
+    static const uint32_t magic = 0x50565254; // "TRVP"
+    static const uint32_t version = 1;
+
+    instruction_profiler(const sc_module_name &name,
+                         const std::string &file = "guest.prof",
+                         unsigned int bucketBits = 6,
+                         unsigned int top = 20) :
+        sc_module(name),
+        file(file),
+        bucketBits(bucketBits),
+        top(top)
+    {
+    }
+
+    void symbol(const std::string &name, uint32_t address, uint32_t size)
+    {
+        symbols[address] = std::make_pair(name, size);
+    }
+
+    void executed(uint32_t pc, CMD cmd, uint64_t n = 1)
+    {
+        site &s = sites[pc >> 2];
+        s.count += n;
+        s.cmd = cmd;
+    }
+
+    void taken(uint32_t pc, uint64_t n = 1)
+    {
+        sites[pc >> 2].taken += n;
+    }
+
+    // The counters stay at the same address until they are folded:
+    block& entered(uint32_t pc)
+    {
+        return blocks[pc >> 2];
+    }
+
+    void load(uint32_t address)
+    {
+        loads[address >> bucketBits]++;
+    }
+
+    void store(uint32_t address)
+    {
+        stores[address >> bucketBits]++;
+    }
+
+    bool write(const std::string &file) const
+    {
+        std::vector<std::pair<uint32_t, site>> s = collect(sites);
+        std::vector<std::pair<uint32_t, uint64_t>> l = collect(loads);
+        std::vector<std::pair<uint32_t, uint64_t>> st = collect(stores);
+
+        uint64_t classes[commands];
+        count(s, classes);
+
+        std::ofstream out(file, std::ios::binary);
+        uint32_t header[6] = {magic, version, bucketBits,
+                              uint32_t(s.size()),
+                              uint32_t(l.size()),
+                              uint32_t(st.size())};
+        out.write(reinterpret_cast<const char*>(header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(classes), sizeof(classes));
+
+        for(auto &e : s)
+        {
+            uint32_t id[2] = {e.first << 2, e.second.cmd};
+            uint64_t n[2] = {e.second.count, e.second.taken};
+            out.write(reinterpret_cast<const char*>(id), sizeof(id));
+            out.write(reinterpret_cast<const char*>(n), sizeof(n));
+        }
+        for(auto *buckets : {&l, &st})
+        {
+            for(auto &e : *buckets)
+            {
+                uint32_t id[2] = {e.first << bucketBits, 0};
+                out.write(reinterpret_cast<const char*>(id), sizeof(id));
+                out.write(reinterpret_cast<const char*>(&e.second),
+                          sizeof(e.second));
+            }
+        }
+
+        return bool(out);
+    }
+
+    void report(std::ostream &os = std::cout) const
+    {
+        std::vector<std::pair<uint32_t, site>> s = collect(sites);
+        uint64_t classes[commands];
+        count(s, classes);
+
+        uint64_t total = 0;
+        for(unsigned int i = 0; i < commands; i++)
+        {
+            total += classes[i];
+        }
+
+        os << std::endl << "Instruction Profile of " << name() << ": "
+           << total << " instructions" << std::endl;
+
+        // Instruction classes and mnemonics:
+        std::map<std::string, uint64_t> groups;
+        std::vector<std::pair<uint64_t, CMD>> mnemonics;
+        for(unsigned int i = 0; i < commands; i++)
+        {
+            if(classes[i])
+            {
+                groups[group(CMD(i))] += classes[i];
+                mnemonics.push_back(std::make_pair(classes[i], CMD(i)));
+            }
+        }
+        std::sort(mnemonics.rbegin(), mnemonics.rend());
+
+        os << std::endl << std::left << std::setw(32) << "class"
+           << std::right << std::setw(14) << "count"
+           << std::setw(8) << "%" << std::endl;
+        for(auto &g : groups)
+        {
+            print(os, g.first, g.second, total);
+        }
+
+        os << std::endl << std::left << std::setw(32) << "mnemonic"
+           << std::right << std::setw(14) << "count"
+           << std::setw(8) << "%" << std::endl;
+        for(auto &m : mnemonics)
+        {
+            print(os, mnemonic(m.second), m.first, total);
+        }
+
+        // Hottest instructions, conditional branches and symbols:
+        std::sort(s.begin(), s.end(),
+                  [](const std::pair<uint32_t, site> &a,
+                     const std::pair<uint32_t, site> &b)
+                  {
+                      return a.second.count > b.second.count;
+                  });
+
+        os << std::endl << std::left << std::setw(32) << "hotspot"
+           << std::right << std::setw(14) << "count"
+           << std::setw(8) << "%" << "  instruction" << std::endl;
+        for(unsigned int i = 0; i < s.size() && i < top; i++)
+        {
+            print(os, locate(s[i].first << 2), s[i].second.count, total,
+                  mnemonic(CMD(s[i].second.cmd)));
+        }
+
+        os << std::endl << std::left << std::setw(32) << "branch"
+           << std::right << std::setw(14) << "taken"
+           << std::setw(14) << "not taken" << "  instruction" << std::endl;
+        unsigned int branches = 0;
+        for(unsigned int i = 0; i < s.size() && branches < top; i++)
+        {
+            if(s[i].second.cmd >= beq && s[i].second.cmd <= bgeu)
+            {
+                os << std::left << std::setw(32)
+                   << locate(s[i].first << 2) << std::right
+                   << std::setw(14) << s[i].second.taken
+                   << std::setw(14) << s[i].second.count - s[i].second.taken
+                   << "  " << mnemonic(CMD(s[i].second.cmd)) << std::endl;
+                branches++;
+            }
+        }
+
+        std::map<std::string, uint64_t> functions;
+        for(auto &e : s)
+        {
+            functions[owner(e.first << 2)] += e.second.count;
+        }
+        std::vector<std::pair<uint64_t, std::string>> sorted;
+        for(auto &f : functions)
+        {
+            sorted.push_back(std::make_pair(f.second, f.first));
+        }
+        std::sort(sorted.rbegin(), sorted.rend());
+
+        os << std::endl << std::left << std::setw(32) << "symbol"
+           << std::right << std::setw(14) << "count"
+           << std::setw(8) << "%" << std::endl;
+        for(unsigned int i = 0; i < sorted.size() && i < top; i++)
+        {
+            print(os, sorted[i].second, sorted[i].first, total);
+        }
+
+        // Memory accesses by address:
+        histogram(os, "loads", collect(loads));
+        histogram(os, "stores", collect(stores));
+    }
+
+    private:
+    std::string file;
+    uint32_t bucketBits;
+    unsigned int top;
+    counters<site> sites;
+    counters<uint64_t> loads;
+    counters<uint64_t> stores;
+    counters<block> blocks;
+    std::map<uint32_t, std::pair<std::string, uint32_t>> symbols;
+
+    void end_of_simulation()
+    {
+        fold();
+        report();
+
+        if(write(file))
+        {
+            std::cout << "Guest profile written to " << file << std::endl;
+        }
+        else
+        {
+            SC_REPORT_WARNING(name(), "Cannot write guest profile");
+        }
+    }
+
+    void fold()
+    {
+        blocks.forEach([this](uint32_t index, const block &b)
+                       {
+                           for(uint32_t pc = index << 2; pc <= b.last; pc += 4)
+                           {
+                               executed(pc, CMD(sites[pc >> 2].cmd), b.count);
+                           }
+                           taken(b.last, b.taken);
+                       });
+        blocks.clear();
+    }
+
+    template <class T>
+    static std::vector<std::pair<uint32_t, T>> collect(const counters<T> &c)
+    {
+        std::vector<std::pair<uint32_t, T>> v;
+        c.forEach([&v](uint32_t index, const T &value)
+                  {
+                      v.push_back(std::make_pair(index, value));
+                  });
+        return v;
+    }
+
+    // Executed instructions per CMD:
+    static void count(const std::vector<std::pair<uint32_t, site>> &s,
+                      uint64_t classes[commands])
+    {
+        std::fill(classes, classes + commands, 0);
+        for(auto &e : s)
+        {
+            classes[e.second.cmd] += e.second.count;
+        }
+    }
+
+    static const char* group(CMD cmd)
+    {
+        if(cmd >= beq && cmd <= bgeu)
+        {
+            return "branch";
+        }
+        if(cmd == jal || cmd == jalr)
+        {
+            return "jump";
+        }
+        if(cmd >= lb && cmd <= lhu)
+        {
+            return "load";
+        }
+        if(cmd >= sb && cmd <= sw)
+        {
+            return "store";
+        }
+        if(cmd >= mul && cmd <= remu)
+        {
+            return "mul/div";
+        }
+        if(cmd == nop || cmd >= fence)
+        {
+            return "system";
+        }
+        return "alu";
+    }
+
+    // Nearest symbol at or below the address:
+    const std::pair<const uint32_t,
+                    std::pair<std::string, uint32_t>>* nearest(
+            uint32_t address) const
+    {
+        auto s = symbols.upper_bound(address);
+        if(s == symbols.begin())
+        {
+            return nullptr;
+        }
+        return &*--s;
+    }
+
+    std::string owner(uint32_t address) const
+    {
+        auto s = nearest(address);
+        return s ? s->second.first : "[unknown]";
+    }
+
+    std::string locate(uint32_t address) const
+    {
+        std::ostringstream os;
+        auto s = nearest(address);
+        if(s)
+        {
+            os << s->second.first;
+            if(address != s->first)
+            {
+                os << "+0x" << std::hex << address - s->first;
+            }
+        }
+        else
+        {
+            os << "0x" << std::hex << address;
+        }
+        return os.str();
+    }
+
+    void histogram(std::ostream &os,
+                   const std::string &title,
+                   std::vector<std::pair<uint32_t, uint64_t>> buckets) const
+    {
+        uint64_t total = 0;
+        for(auto &b : buckets)
+        {
+            total += b.second;
+        }
+        std::sort(buckets.begin(), buckets.end(),
+                  [](const std::pair<uint32_t, uint64_t> &a,
+                     const std::pair<uint32_t, uint64_t> &b)
+                  {
+                      return a.second > b.second;
+                  });
+
+        os << std::endl << std::left << std::setw(32)
+           << title + " (" + std::to_string(1u << bucketBits) + " byte)"
+           << std::right << std::setw(14) << "count"
+           << std::setw(8) << "%" << std::endl;
+        for(unsigned int i = 0; i < buckets.size() && i < top; i++)
+        {
+            print(os, locate(buckets[i].first << bucketBits),
+                  buckets[i].second, total);
+        }
+    }
+
+    static void print(std::ostream &os,
+                      const std::string &name,
+                      uint64_t count,
+                      uint64_t total,
+                      const char *suffix = nullptr)
+    {
+        std::streamsize precision = os.precision();
+        os << std::left << std::setw(32) << name << std::right
+           << std::setw(14) << count
+           << std::setw(8) << std::fixed << std::setprecision(1)
+           << (total ? 100.0 * count / total : 0.0)
+           << std::defaultfloat << std::setprecision(precision);
+        if(suffix)
+        {
+            os << "  " << suffix;
+        }
+        os << std::endl;
+    }
+};
+
+#endif // INSTRUCTION_PROFILER_H
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2017 Matthias Jung
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef INTERRUPTS_H
+#define INTERRUPTS_H
+
+#include <vector>
+#include <systemc.h>
+
+// Interrupt inputs of a hart. The sources call these only when something
+// changes, the hart folds them into the time of its next interrupt and
+// compares that time at its block and quantum boundaries. So neither a
+// signal nor a device register is polled per instruction, and a temporally
+// decoupled hart stays decoupled.
+class interruptible
+{
+    public:
+    virtual ~interruptible()
+    {
+    }
+
+    // Absolute simulation time at which the timer interrupt becomes pending,
+    // sc_max_time() if it never does:
+    virtual void setTimer(const sc_time &deadline) = 0;
+
+    virtual void setSoftware(bool pending) = 0;
+
+    virtual void setExternal(bool pending) = 0;
+};
+
+// Connects a level sensitive interrupt signal, e.g. of a device or of an
+// interrupt controller, to the external interrupt input of harts. The
+// method runs only when the level changes.
+SC_MODULE(interrupt_line)
+{
+    public:
+    sc_in<bool> irq;
+
+    SC_CTOR(interrupt_line) : irq("irq")
+    {
+        SC_METHOD(changed);
+        sensitive << irq;
+        dont_initialize();
+    }
+
+    void attach(interruptible &hart)
+    {
+        harts.push_back(&hart);
+    }
+
+    private:
+    std::vector<interruptible*> harts;
+
+    void changed()
+    {
+        for(interruptible *hart : harts)
+        {
+            hart->setExternal(irq.read());
+        }
+    }
+};
+
+#endif // INTERRUPTS_H
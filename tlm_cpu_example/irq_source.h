@@ -0,0 +1,138 @@
+/*
+ * Copyright 2017 Matthias Jung
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef IRQ_SOURCE_H
+#define IRQ_SOURCE_H
+
+#include <cstdint>
+#include <cstring>
+#include <systemc.h>
+#include <tlm.h>
+#include <tlm_utils/multi_passthrough_target_socket.h>
+
+// Device that raises a level sensitive interrupt periodically, e.g. for the
+// external interrupt input of the harts via an interrupt_line. One register
+// at offset 0: a read returns the number of raised interrupts, a write
+// acknowledges, i.e. lowers the line. The line is only driven by the
+// method of the device, so the lowered level becomes visible to a
+// temporally decoupled hart when it synchronizes next, e.g. at a FENCE.
+class irq_source : sc_module
+{
+    public:
+    tlm_utils::multi_passthrough_target_socket<irq_source> tSocket;
+    sc_out<bool> irq;
+
+    // Region of the device in the memory map of the platform:
+    enum : uint64_t
+    {
+        base = 0x0c000000,
+        size = 0x1000
+    };
+
+    SC_HAS_PROCESS(irq_source);
+    irq_source(sc_module_name name, sc_time period) :
+        sc_module(name),
+        tSocket("tSocket"),
+        irq("irq"),
+        period(period),
+        raised(0),
+        level(false)
+    {
+        tSocket.register_b_transport(this, &irq_source::b_transport);
+        tSocket.register_transport_dbg(this, &irq_source::transport_dbg);
+
+        SC_THREAD(run);
+
+        SC_METHOD(drive);
+        sensitive << changed;
+        dont_initialize();
+    }
+
+    private:
+    sc_time period;
+    uint32_t raised;
+    bool level;
+    sc_event changed;
+
+    void run()
+    {
+        while(true)
+        {
+            wait(period);
+            raised++;
+            level = true;
+            changed.notify(SC_ZERO_TIME);
+        }
+    }
+
+    void drive()
+    {
+        irq.write(level);
+    }
+
+    void b_transport(int id, tlm::tlm_generic_payload &trans, sc_time &delay)
+    {
+        delay += sc_time(1, SC_NS);
+
+        if(!access(trans))
+        {
+            trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+            return;
+        }
+
+        if(trans.is_write())
+        {
+            level = false;
+            changed.notify(SC_ZERO_TIME);
+        }
+        trans.set_response_status(tlm::TLM_OK_RESPONSE);
+    }
+
+    // Debug reads have no side effects:
+    unsigned int transport_dbg(int id, tlm::tlm_generic_payload &trans)
+    {
+        return trans.is_read() && access(trans) ? 4 : 0;
+    }
+
+    bool access(tlm::tlm_generic_payload &trans)
+    {
+        if(trans.get_address() != 0 || trans.get_data_length() != 4)
+        {
+            return false;
+        }
+        if(trans.is_read())
+        {
+            memcpy(trans.get_data_ptr(), &raised, 4);
+        }
+        return true;
+    }
+};
+
+#endif // IRQ_SOURCE_H
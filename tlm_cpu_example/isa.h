@@ -0,0 +1,214 @@
+/*
+ * Copyright 2017 Matthias Jung
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ISA_H
+#define ISA_H
+
+#include <cstdint>
+
+// RV32IM, a superset of TinyRV1:
+// - LUI, AUIPC
+// - JAL, JALR (TinyRV1: JR)
+// - BEQ, BNE, BLT, BGE, BLTU, BGEU
+// - LB, LH, LW, LBU, LHU
+// - SB, SH, SW
+// - ADDI, SLTI, SLTIU, XORI, ORI, ANDI, SLLI, SRLI, SRAI
+// - ADD, SUB, SLL, SLT, SLTU, XOR, SRL, SRA, OR, AND
+// - MUL, MULH, MULHSU, MULHU, DIV, DIVU, REM, REMU
+// - FENCE (synchronizes the core with the other cores)
+// - ECALL (exit with a7 = 93), EBREAK (halt)
+// - CSRRW, CSRRS, CSRRC, CSRRWI, CSRRSI, CSRRCI of the machine mode
+//   interrupt CSRs, MRET, WFI (sleeps until the next timer interrupt)
+//
+// An all-zero word is decoded as nop, after more than 10 nops the cpu
+// halts.
+
+enum CMD
+{
+    nop,
+    lui, auipc,
+    jal, jalr,
+    beq, bne, blt, bge, bltu, bgeu,
+    lb, lh, lw, lbu, lhu,
+    sb, sh, sw,
+    addi, slti, sltiu, xori, ori, andi, slli, srli, srai,
+    add, sub, sll, slt, sltu, xor_, srl, sra, or_, and_,
+    mul, mulh, mulhsu, mulhu, div_, divu, rem, remu,
+    fence,
+    ecall, ebreak,
+    csrrw, csrrs, csrrc, csrrwi, csrrsi, csrrci,
+    mret, wfi
+};
+
+const unsigned int commands = wfi + 1;
+
+inline const char* mnemonic(CMD cmd)
+{
+    static const char *names[commands] =
+    {
+        "nop",
+        "lui", "auipc",
+        "jal", "jalr",
+        "beq", "bne", "blt", "bge", "bltu", "bgeu",
+        "lb", "lh", "lw", "lbu", "lhu",
+        "sb", "sh", "sw",
+        "addi", "slti", "sltiu", "xori", "ori", "andi",
+        "slli", "srli", "srai",
+        "add", "sub", "sll", "slt", "sltu", "xor", "srl", "sra", "or", "and",
+        "mul", "mulh", "mulhsu", "mulhu", "div", "divu", "rem", "remu",
+        "fence",
+        "ecall", "ebreak",
+        "csrrw", "csrrs", "csrrc", "csrrwi", "csrrsi", "csrrci",
+        "mret", "wfi"
+    };
+    return names[cmd];
+}
+
+enum OPCODE : uint32_t
+{
+    op_lui    = 0b0110111,
+    op_auipc  = 0b0010111,
+    op_jal    = 0b1101111,
+    op_jalr   = 0b1100111,
+    op_branch = 0b1100011,
+    op_load   = 0b0000011,
+    op_store  = 0b0100011,
+    op_imm    = 0b0010011,
+    op_reg    = 0b0110011,
+    op_fence  = 0b0001111,
+    op_system = 0b1110011
+};
+
+enum FUNCT3 : uint32_t
+{
+    f3_jalr  = 0b000,
+    f3_beq   = 0b000,
+    f3_bne   = 0b001,
+    f3_blt   = 0b100,
+    f3_bge   = 0b101,
+    f3_bltu  = 0b110,
+    f3_bgeu  = 0b111,
+    f3_lb    = 0b000,
+    f3_lh    = 0b001,
+    f3_lw    = 0b010,
+    f3_lbu   = 0b100,
+    f3_lhu   = 0b101,
+    f3_sb    = 0b000,
+    f3_sh    = 0b001,
+    f3_sw    = 0b010,
+    f3_add   = 0b000, // ADD(I), SUB, MUL
+    f3_sll   = 0b001, // SLL(I), MULH
+    f3_slt   = 0b010, // SLT(I), MULHSU
+    f3_sltu  = 0b011, // SLT(I)U, MULHU
+    f3_xor   = 0b100, // XOR(I), DIV
+    f3_srl   = 0b101, // SRL(I), SRA(I), DIVU
+    f3_or    = 0b110, // OR(I), REM
+    f3_and   = 0b111, // AND(I), REMU
+    f3_fence = 0b000,
+    f3_fencei = 0b001,
+    f3_csrrw  = 0b001,
+    f3_csrrs  = 0b010,
+    f3_csrrc  = 0b011,
+    f3_csrrwi = 0b101,
+    f3_csrrsi = 0b110,
+    f3_csrrci = 0b111
+};
+
+enum FUNCT7 : uint32_t
+{
+    f7_add = 0b0000000,
+    f7_sub = 0b0100000, // SUB, SRA(I)
+    f7_mul = 0b0000001
+};
+
+// Machine mode CSRs of the interrupt subsystem:
+enum CSR : uint32_t
+{
+    csr_mstatus  = 0x300,
+    csr_mie      = 0x304,
+    csr_mtvec    = 0x305,
+    csr_mscratch = 0x340,
+    csr_mepc     = 0x341,
+    csr_mcause   = 0x342,
+    csr_mip      = 0x344,
+    csr_mhartid  = 0xf14
+};
+
+// Bits of mstatus and of mie and mip, the bit number of an interrupt in mip
+// is its cause:
+enum CSR_BITS : uint32_t
+{
+    mstatus_mie  = 1u << 3,
+    mstatus_mpie = 1u << 7,
+    mip_msip     = 1u << 3,
+    mip_mtip     = 1u << 7,
+    mip_meip     = 1u << 11
+};
+
+// Control transfers and instructions that need the cpu loop end a basic
+// block:
+inline bool endsBlock(CMD cmd)
+{
+    return (cmd >= jal && cmd <= bgeu) || cmd == nop || cmd >= fence;
+}
+
+// Immediates of the instruction formats, sign extended:
+inline int32_t immI(uint32_t data)
+{
+    return ((int32_t)data) >> 20;
+}
+
+inline int32_t immS(uint32_t data)
+{
+    return (((int32_t)data >> 20) & ~0b11111) | ((data >> 7) & 0b11111);
+}
+
+inline int32_t immB(uint32_t data)
+{
+    return (((int32_t)data >> 19) & ~0b111111111111)  // imm[31:12]
+         | ((data << 4) & 0b100000000000)              // imm[11]
+         | ((data >> 20) & 0b11111100000)              // imm[10:5]
+         | ((data >> 7) & 0b11110);                    // imm[4:1]
+}
+
+inline int32_t immU(uint32_t data)
+{
+    return (int32_t)(data & 0b11111111111111111111000000000000);
+}
+
+inline int32_t immJ(uint32_t data)
+{
+    return (((int32_t)data >> 11) & ~0b11111111111111111111) // imm[31:20]
+         | (data & 0b11111111000000000000)                   // imm[19:12]
+         | ((data >> 9) & 0b100000000000)                    // imm[11]
+         | ((data >> 20) & 0b11111111110);                   // imm[10:1]
+}
+
+#endif // ISA_H
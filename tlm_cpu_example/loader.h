@@ -0,0 +1,169 @@
+/*
+ * Copyright 2017 Matthias Jung
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LOADER_H
+#define LOADER_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "elf32.h"
+
+// Program file that is mapped read-only into the host address space. The
+// file is either an RV32 ELF executable or a raw binary of assembler.pl,
+// which is loaded to address 0 and started there. The file descriptor
+// stays open, so that a memory can map the pages of the file directly as
+// copy-on-write backing store, see mem::load().
+class program_image
+{
+    public:
+    program_image(const std::string &file) :
+        file(file),
+        fd(-1),
+        data(nullptr),
+        length(0),
+        elf(false),
+        start(0)
+    {
+        fd = open(file.c_str(), O_RDONLY);
+        if(fd < 0)
+        {
+            return;
+        }
+
+        struct stat s;
+        if(fstat(fd, &s) == 0 && s.st_size > 0)
+        {
+            void *m = mmap(nullptr, s.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(m != MAP_FAILED)
+            {
+                data = static_cast<const unsigned char*>(m);
+                length = s.st_size;
+            }
+        }
+
+        elf = data && elf32::is_elf(data, length);
+        if(elf && !elf32::load_segments(data, length, start,
+                [](uint32_t, const unsigned char*, uint32_t, uint32_t) {}))
+        {
+            // Not a valid RV32 executable:
+            munmap(const_cast<unsigned char*>(data), length);
+            data = nullptr;
+        }
+    }
+
+    ~program_image()
+    {
+        if(data)
+        {
+            munmap(const_cast<unsigned char*>(data), length);
+        }
+        if(fd >= 0)
+        {
+            close(fd);
+        }
+    }
+
+    bool ok() const
+    {
+        return data != nullptr;
+    }
+
+    const std::string& name() const
+    {
+        return file;
+    }
+
+    int descriptor() const
+    {
+        return fd;
+    }
+
+    const unsigned char* bytes() const
+    {
+        return data;
+    }
+
+    size_t size() const
+    {
+        return length;
+    }
+
+    uint32_t entry() const
+    {
+        return start;
+    }
+
+    // Calls segment(address, file offset, filesz, memsz) for every segment
+    // to load, a raw binary is a single segment at address 0:
+    bool segments(const std::function<void(uint32_t, uint64_t,
+                                           uint32_t, uint32_t)> &segment) const
+    {
+        if(!elf)
+        {
+            segment(0, 0, length, length);
+            return true;
+        }
+
+        uint32_t e;
+        return elf32::load_segments(data, length, e,
+            [this, &segment](uint32_t address, const unsigned char *d,
+                             uint32_t filesz, uint32_t memsz)
+            {
+                segment(address, d - data, filesz, memsz);
+            });
+    }
+
+    // Symbols of an ELF executable for the instruction_profiler:
+    bool symbols(const std::function<void(const char*, uint32_t,
+                                          uint32_t)> &symbol) const
+    {
+        return elf && elf32::load_symbols(data, length, symbol);
+    }
+
+    private:
+    std::string file;
+    int fd;
+    const unsigned char *data;
+    size_t length;
+    bool elf;
+    uint32_t start;
+
+    program_image(const program_image&) = delete;
+    program_image& operator=(const program_image&) = delete;
+};
+
+#endif // LOADER_H
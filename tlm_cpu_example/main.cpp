@@ -31,22 +31,525 @@
  *     - Matthias Jung
  */
 
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <map>
+#include <string>
+#include <vector>
 #include "memory.h"
+#include "bus.h"
+#include "cache.h"
+#include "clint.h"
 #include "cpu.h"
+#include "irq_source.h"
+#include "parallel_executor.h"
 
 using namespace std;
 
-int sc_main (int __attribute__((unused)) sc_argc,
-             char __attribute__((unused)) *sc_argv[])
+// Interrupt sources of the platform: the CLINT and a device that raises the
+// external interrupt of all harts periodically. Both are bound to every bus
+// or decoder after the memory:
+struct interrupt_sources
 {
+    clint * timer = nullptr;
+    irq_source * device = nullptr;
 
-    cpu * cpu1 = new cpu("cpu1");
-    mem * mem1 = new mem("memory");
+    interrupt_sources(const vector<cpu*> &cpus, bool withTimer, unsigned int tick,
+                      unsigned int period)
+    {
+        if (withTimer)
+        {
+            timer = new clint("clint", sc_time(tick, SC_NS));
+            for (cpu * c : cpus)
+            {
+                timer->attach(*c);
+            }
+        }
+        if (period > 0)
+        {
+            device = new irq_source("device", sc_time(period, SC_NS));
+            sc_signal<bool> * irq = new sc_signal<bool>("irq");
+            interrupt_line * line = new interrupt_line("line");
+            device->irq.bind(*irq);
+            line->irq.bind(*irq);
+            for (cpu * c : cpus)
+            {
+                line->attach(*c);
+            }
+        }
+    }
 
-    cpu1->iSocket.bind(mem1->tSocket);
+    void map(bus &b)
+    {
+        unsigned int target = 1;
+        if (timer)
+        {
+            b.iSocket.bind(timer->tSocket);
+            b.map(target++, clint::base, clint::size);
+        }
+        if (device)
+        {
+            b.iSocket.bind(device->tSocket);
+            b.map(target++, irq_source::base, irq_source::size);
+        }
+    }
+};
 
+// Installs the program image as backing store of the memory:
+static bool load(const program_image &image, mem &memory)
+{
+    if (!image.ok())
+    {
+        cerr << "Cannot load program " << image.name() << endl;
+        return false;
+    }
+    if (!memory.load(image))
+    {
+        cerr << "Program " << image.name() << " does not fit into memory"
+             << endl;
+        return false;
+    }
+    return true;
+}
+
+int sc_main (int sc_argc, char *sc_argv[])
+{
+    // Usage: tlm_cpu_example [profile]
+    //                        [save <file> <instructions>]
+    //                        [restore <file>]
+    //                        [multicore <cores> <quantum in ns>]
+    //                        [parallel <cores> <quantum in ns> <threads>]
+    //                        [program <raw binary or ELF> [<memory in KiB>]]
+    //                        [quantum <quantum in ns>]
+    //                        [cpuquantum <core> <quantum in ns>]...
+    //                        [dbt]
+    //                        [hotspots]
+    //                        [cache <KiB> <ways> <line bytes> [lru|fifo|random]]
+    //                        [clint [<mtime tick in ns>]]
+    //                        [irq [<period in ns>]]
+    string saveFile;
+    uint64_t saveAfter = 0;
+    string restoreFile;
+    unsigned int cores = 0;
+    unsigned int quantum = 0;
+    map<unsigned int, unsigned int> cpuQuanta;
+    bool parallel = false;
+    unsigned int threads = 0;
+    string program;
+    size_t memorySize = 1024;
+    bool translation = false;
+    bool hotspots = false;
+    bool cached = false;
+    cache::config cacheConfig = {32 * 1024, 4, 64, cache::lru,
+                                 sc_time(1, SC_NS)};
+    bool timer = false;
+    unsigned int tick = 100;
+    unsigned int period = 0;
+
+    for (int i = 1; i < sc_argc; i++)
+    {
+        if (strcmp(sc_argv[i], "profile") == 0)
+        {
+            // Registers itself, reports at end_of_simulation:
+            new process_profiler("profiler", "tlm_cpu_example.folded");
+        }
+        else if (strcmp(sc_argv[i], "save") == 0 && i + 2 < sc_argc)
+        {
+            saveFile = sc_argv[i+1];
+            saveAfter = strtoull(sc_argv[i+2], NULL, 10);
+            i += 2;
+        }
+        else if (strcmp(sc_argv[i], "restore") == 0 && i + 1 < sc_argc)
+        {
+            restoreFile = sc_argv[i+1];
+            i += 1;
+        }
+        else if (strcmp(sc_argv[i], "multicore") == 0 && i + 2 < sc_argc)
+        {
+            cores = atoi(sc_argv[i+1]);
+            quantum = atoi(sc_argv[i+2]);
+            i += 2;
+        }
+        else if (strcmp(sc_argv[i], "parallel") == 0 && i + 3 < sc_argc)
+        {
+            parallel = true;
+            cores = atoi(sc_argv[i+1]);
+            quantum = atoi(sc_argv[i+2]);
+            threads = atoi(sc_argv[i+3]);
+            i += 3;
+        }
+        else if (strcmp(sc_argv[i], "program") == 0 && i + 1 < sc_argc)
+        {
+            program = sc_argv[i+1];
+            memorySize = 64 * 1024;
+            i += 1;
+            if (i + 1 < sc_argc && isdigit(sc_argv[i+1][0]))
+            {
+                memorySize = atoi(sc_argv[i+1]) * 1024;
+                i += 1;
+            }
+        }
+        else if (strcmp(sc_argv[i], "quantum") == 0 && i + 1 < sc_argc)
+        {
+            quantum = atoi(sc_argv[i+1]);
+            i += 1;
+        }
+        else if (strcmp(sc_argv[i], "cpuquantum") == 0 && i + 2 < sc_argc)
+        {
+            // Overrides the quantum for one core of multicore or parallel:
+            cpuQuanta[atoi(sc_argv[i+1])] = atoi(sc_argv[i+2]);
+            i += 2;
+        }
+        else if (strcmp(sc_argv[i], "dbt") == 0)
+        {
+            // Translated blocks are chained up to the quantum boundary, their
+            // loads and stores use DMI:
+            translation = true;
+        }
+        else if (strcmp(sc_argv[i], "hotspots") == 0)
+        {
+            // Guest profile of every cpu, written to <cpu>.prof:
+            hotspots = true;
+        }
+        else if (strcmp(sc_argv[i], "cache") == 0 && i + 3 < sc_argc)
+        {
+            cached = true;
+            cacheConfig.size = atoi(sc_argv[i+1]) * 1024;
+            cacheConfig.associativity = atoi(sc_argv[i+2]);
+            cacheConfig.lineSize = atoi(sc_argv[i+3]);
+            i += 3;
+            if (i + 1 < sc_argc && strcmp(sc_argv[i+1], "lru") == 0)
+            {
+                i += 1;
+            }
+            else if (i + 1 < sc_argc && strcmp(sc_argv[i+1], "fifo") == 0)
+            {
+                cacheConfig.replacement = cache::fifo;
+                i += 1;
+            }
+            else if (i + 1 < sc_argc && strcmp(sc_argv[i+1], "random") == 0)
+            {
+                cacheConfig.replacement = cache::random;
+                i += 1;
+            }
+        }
+        else if (strcmp(sc_argv[i], "clint") == 0)
+        {
+            // Timer and software interrupts at clint::base:
+            timer = true;
+            if (i + 1 < sc_argc && isdigit(sc_argv[i+1][0]))
+            {
+                tick = atoi(sc_argv[i+1]);
+                i += 1;
+            }
+        }
+        else if (strcmp(sc_argv[i], "irq") == 0)
+        {
+            // External interrupts of the device at irq_source::base:
+            period = 10000;
+            if (i + 1 < sc_argc && isdigit(sc_argv[i+1][0]))
+            {
+                period = atoi(sc_argv[i+1]);
+                i += 1;
+            }
+        }
+        else
+        {
+            cerr << "Unknown argument " << sc_argv[i] << endl;
+            return 1;
+        }
+    }
+
+    bool interrupts = timer || period > 0;
+
+    if (interrupts && (!saveFile.empty() || !restoreFile.empty()))
+    {
+        cerr << "Checkpoints do not contain the interrupt state" << endl;
+        return 1;
+    }
+
+    if (interrupts && parallel)
+    {
+        cerr << "The interrupt sources need a shared bus" << endl;
+        return 1;
+    }
+
+    if (!cpuQuanta.empty() && (cores == 0 || threads > 0))
+    {
+        // The workers of the executor all run with its quantum:
+        cerr << "Core quanta need multicore or parallel with 0 threads"
+             << endl;
+        return 1;
+    }
+
+    if (!cpuQuanta.empty() && cpuQuanta.rbegin()->first >= cores)
+    {
+        cerr << "No core " << cpuQuanta.rbegin()->first << endl;
+        return 1;
+    }
+
+    if (cores == 0)
+    {
+        cpu * cpu1 = new cpu("cpu1");
+        mem * mem1 = new mem("memory", memorySize);
+
+        cpu::setQuantum(sc_time(quantum, SC_NS));
+        cpu1->setTranslation(translation);
+        cpu1->setDmi(translation);
+        if (hotspots)
+        {
+            cpu1->setProfiler(new instruction_profiler("cpu1_profiler",
+                                                       "cpu1.prof"));
+        }
+
+        program_image * image = new program_image(
+            program.empty() ? "test.asm.bin" : program);
+
+        if (!program.empty())
+        {
+            cpu1->setVerbose(false);
+        }
+        if (!saveFile.empty())
+        {
+            cpu1->saveCheckpoint(saveFile, saveAfter, mem1->size());
+        }
+        if (!restoreFile.empty())
+        {
+            // The memory contents come from the checkpoint:
+            cpu1->restoreCheckpoint(restoreFile);
+        }
+        else if (!load(*image, *mem1))
+        {
+            return 1;
+        }
+        if (image->ok())
+        {
+            cpu1->setProgram(*image);
+        }
+
+        if (interrupts)
+        {
+            // The interrupt sources are not cacheable, so the bus sits in
+            // front of the cache:
+            bus * bus1 = new bus("bus");
+            interrupt_sources sources({cpu1}, timer, tick, period);
+            cpu1->iSocket.bind(bus1->tSocket);
+            if (cached)
+            {
+                cache * cache1 = new cache("cache", cacheConfig);
+                bus1->iSocket.bind(cache1->tSocket);
+                cache1->iSocket.bind(mem1->tSocket);
+            }
+            else
+            {
+                bus1->iSocket.bind(mem1->tSocket);
+            }
+            sources.map(*bus1);
+        }
+        else if (cached)
+        {
+            cache * cache1 = new cache("cache", cacheConfig);
+            cpu1->iSocket.bind(cache1->tSocket);
+            cache1->iSocket.bind(mem1->tSocket);
+        }
+        else
+        {
+            cpu1->iSocket.bind(mem1->tSocket);
+        }
+
+        auto start = chrono::steady_clock::now();
+        sc_start();
+        auto stop = chrono::steady_clock::now();
+
+        if (!program.empty())
+        {
+            double seconds = chrono::duration<double>(stop - start).count();
+            cout << program << ": exit code " << cpu1->getExitCode()
+                 << ", " << cpu1->getInstructions() << " instructions in "
+                 << seconds << " s ("
+                 << cpu1->getInstructions() / seconds / 1e6
+                 << " MIPS), simulated " << sc_time_stamp() << endl;
+        }
+
+        return cpu1->getExitCode();
+    }
+
+    if (!saveFile.empty() || !restoreFile.empty())
+    {
+        cerr << "Checkpoints are only supported with one core" << endl;
+        return 1;
+    }
+
+    if (threads > 0 && quantum == 0)
+    {
+        cerr << "Parallel execution needs a quantum" << endl;
+        return 1;
+    }
+
+    if (threads > 0 && cached)
+    {
+        // The cache is a SystemC module, so every access of a worker would
+        // be serialized through the SystemC thread of the executor:
+        cerr << "Caches need parallel with 0 threads or multicore" << endl;
+        return 1;
+    }
+
+    cpu::setQuantum(sc_time(quantum, SC_NS));
+
+    // With a shared memory the program has to keep the data and stacks of
+    // the cores apart itself, e.g. by mhartid:
+    program_image * image = new program_image(
+        program.empty() ? "bench.asm.bin" : program);
+    if (!image->ok())
+    {
+        cerr << "Cannot load program " << image->name() << endl;
+        return 1;
+    }
+
+    vector<cpu*> cpus;
+    for (unsigned int i = 0; i < cores; i++)
+    {
+        cpu * c = new cpu(("cpu" + to_string(i)).c_str());
+        c->setProgram(*image);
+        c->setHartId(i);
+        c->setVerbose(false);
+        c->setTranslation(translation);
+        if (cpuQuanta.count(i))
+        {
+            c->setCpuQuantum(sc_time(cpuQuanta[i], SC_NS));
+        }
+        if (hotspots)
+        {
+            string name = "cpu" + to_string(i);
+            c->setProfiler(new instruction_profiler(
+                (name + "_profiler").c_str(), name + ".prof"));
+        }
+        cpus.push_back(c);
+    }
+
+    if (!parallel)
+    {
+        // All cores execute the program from the shared memory, with a
+        // shared cache the cores are bound to the cache directly, which
+        // keeps statistics per core. With interrupt sources every core has
+        // a decoder of its own in front of the cache or the bus, so the
+        // cache still tells the cores apart:
+        bus * bus1 = new bus("bus");
+        mem * mem1 = new mem("memory", memorySize);
+        cache * cache1 = nullptr;
+
+        if (cached)
+        {
+            cache1 = new cache("cache", cacheConfig);
+            cache1->iSocket.bind(bus1->tSocket);
+        }
+        bus1->iSocket.bind(mem1->tSocket);
+
+        if (interrupts)
+        {
+            interrupt_sources sources(cpus, timer, tick, period);
+            for (unsigned int i = 0; i < cores; i++)
+            {
+                bus * decoder = new bus(("decoder" + to_string(i)).c_str(),
+                                        SC_ZERO_TIME);
+                cpus[i]->iSocket.bind(decoder->tSocket);
+                if (cached)
+                {
+                    decoder->iSocket.bind(cache1->tSocket);
+                }
+                else
+                {
+                    decoder->iSocket.bind(bus1->tSocket);
+                }
+                sources.map(*decoder);
+            }
+        }
+        else
+        {
+            for (cpu * c : cpus)
+            {
+                if (cached)
+                {
+                    c->iSocket.bind(cache1->tSocket);
+                }
+                else
+                {
+                    c->iSocket.bind(bus1->tSocket);
+                }
+            }
+        }
+
+        if (!load(*image, *mem1))
+        {
+            return 1;
+        }
+    }
+    else
+    {
+        // Every core has a private memory, which it accesses with DMI, or a
+        // private cache in front of it. With threads == 0 the cores run
+        // sequentially in their SC_THREADs:
+        parallel_executor * executor = nullptr;
+        if (threads > 0)
+        {
+            executor = new parallel_executor("executor",
+                                             sc_time(quantum, SC_NS),
+                                             threads);
+        }
+
+        for (unsigned int i = 0; i < cores; i++)
+        {
+            mem * m = new mem(("memory" + to_string(i)).c_str(), memorySize);
+            if (!load(*image, *m))
+            {
+                return 1;
+            }
+            if (cached)
+            {
+                cache * c = new cache(("cache" + to_string(i)).c_str(),
+                                      cacheConfig);
+                cpus[i]->iSocket.bind(c->tSocket);
+                c->iSocket.bind(m->tSocket);
+            }
+            else
+            {
+                cpus[i]->iSocket.bind(m->tSocket);
+            }
+            cpus[i]->setDmi(true);
+            if (executor)
+            {
+                cpus[i]->setExecutor(executor);
+            }
+        }
+    }
+
+    auto start = chrono::steady_clock::now();
     sc_start();
+    auto stop = chrono::steady_clock::now();
+
+    double seconds = chrono::duration<double>(stop - start).count();
+    uint64_t instructions = 0;
+    for (cpu * c : cpus)
+    {
+        instructions += c->getInstructions();
+    }
+
+    cout << cores << " cores, quantum " << quantum << " ns, "
+         << threads << " threads: "
+         << instructions << " instructions in "
+         << seconds << " s (" << instructions / seconds / 1e6
+         << " MIPS), simulated " << sc_time_stamp() << endl;
 
+    // A program fails if it fails on any of the cores:
+    for (cpu * c : cpus)
+    {
+        if (c->getExitCode() != 0)
+        {
+            return c->getExitCode();
+        }
+    }
     return 0;
 }
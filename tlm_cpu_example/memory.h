@@ -37,33 +37,117 @@
 #include <systemc.h>
 #include <tlm.h>
 
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "loader.h"
+
+// The storage is an anonymous mapping, so untouched pages cost nothing,
+// and program images are mapped into it copy-on-write by load().
 class mem : sc_module, tlm::tlm_fw_transport_if<>
 {
     private:
-    unsigned char data[1024];
+    unsigned char *data;
+    size_t bytes;
+    size_t mapped;
 
     public:
     tlm::tlm_target_socket<> tSocket;
 
-    SC_CTOR(mem) : tSocket("tSocket")
+    mem(sc_module_name name, size_t size = 1024) :
+        sc_module(name),
+        data(nullptr),
+        bytes(size),
+        mapped(0),
+        tSocket("tSocket")
     {
-        tSocket.bind(*this);
+        size_t page = sysconf(_SC_PAGESIZE);
+        mapped = (size + page - 1) / page * page;
 
-        for(int i = 0; i < 1024; i++)
+        void *m = mmap(nullptr, mapped, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(m == MAP_FAILED)
         {
-            data[i] = 0;
+            SC_REPORT_FATAL(this->name(), "Cannot allocate memory");
         }
+        data = static_cast<unsigned char*>(m);
+
+        tSocket.bind(*this);
+    }
+
+    ~mem()
+    {
+        munmap(data, mapped);
+    }
+
+    size_t size() const
+    {
+        return bytes;
+    }
+
+    // Installs the segments of a program image. Whole pages of the file are
+    // mapped copy-on-write, so the file is neither read nor copied before
+    // the cpu touches a page. Partial pages at the segment borders are
+    // copied, the rest of a segment up to memsz is zeroed. Returns false if
+    // the image does not fit into the memory.
+    bool load(const program_image &image)
+    {
+        size_t page = sysconf(_SC_PAGESIZE);
+        bool fits = true;
+
+        bool ok = image.segments(
+            [&](uint32_t address, uint64_t offset,
+                uint32_t filesz, uint32_t memsz)
+            {
+                if(uint64_t(address) + memsz > bytes)
+                {
+                    fits = false;
+                    return;
+                }
+
+                uint64_t end = uint64_t(address) + filesz;
+                uint64_t first = (address + page - 1) / page * page;
+                uint64_t last = end / page * page;
+
+                if((offset - address) % page == 0 && first < last)
+                {
+                    void *m = mmap(data + first, last - first,
+                                   PROT_READ | PROT_WRITE,
+                                   MAP_PRIVATE | MAP_FIXED,
+                                   image.descriptor(),
+                                   offset + (first - address));
+                    if(m == MAP_FAILED)
+                    {
+                        first = last = end;
+                    }
+                }
+                else
+                {
+                    first = last = end;
+                }
+
+                memcpy(data + address, image.bytes() + offset,
+                       first - address);
+                memcpy(data + last, image.bytes() + offset + (last - address),
+                       end - last);
+                memset(data + end, 0, memsz - filesz);
+            });
+
+        return ok && fits;
     }
 
     void b_transport(tlm::tlm_generic_payload &trans, sc_time &delay)
     {
-        if (trans.get_address() >= 1024)
+        if (trans.get_address() + trans.get_data_length() > bytes)
         {
              trans.set_response_status( tlm::TLM_ADDRESS_ERROR_RESPONSE );
              return;
         }
 
-        if (trans.get_data_length() != 4)
+        // Byte, halfword and word accesses, and bursts of words:
+        if (trans.get_data_length() != 1
+            && trans.get_data_length() != 2
+            && trans.get_data_length() % 4 != 0)
         {
              trans.set_response_status( tlm::TLM_BURST_ERROR_RESPONSE );
              return;
@@ -71,18 +155,20 @@ class mem : sc_module, tlm::tlm_fw_transport_if<>
 
         if(trans.get_command() == tlm::TLM_WRITE_COMMAND)
         {
-            memcpy(&data[trans.get_address()], // destination
+            memcpy(data + trans.get_address(), // destination
                    trans.get_data_ptr(),      // source
                    trans.get_data_length()); // size
         }
         else // (trans.get_command() == tlm::TLM_READ_COMMAND)
         {
             memcpy(trans.get_data_ptr(),        // destination
-                   &data[trans.get_address()], // source
+                   data + trans.get_address(), // source
                    trans.get_data_length());  // size
         }
 
-        delay = delay + sc_time(1, SC_NS);
+        // The first word takes 1 ns, every further word of a burst 250 ps:
+        delay = delay + sc_time(1, SC_NS)
+              + sc_time(250, SC_PS) * ((trans.get_data_length() - 1) / 4);
 
         trans.set_response_status( tlm::TLM_OK_RESPONSE );
     }
@@ -97,36 +183,45 @@ class mem : sc_module, tlm::tlm_fw_transport_if<>
         return tlm::TLM_ACCEPTED;
     }
 
-    // Dummy method
+    // Grants read and write access to the whole memory:
     bool get_direct_mem_ptr(tlm::tlm_generic_payload& trans,
                             tlm::tlm_dmi& dmi_data)
     {
-        SC_REPORT_FATAL(this->name(),"get_direct_mem_ptr is not implemented");
-        return false;
+        dmi_data.set_dmi_ptr(data);
+        dmi_data.set_start_address(0);
+        dmi_data.set_end_address(bytes - 1);
+        dmi_data.allow_read_write();
+        dmi_data.set_read_latency(sc_time(1, SC_NS));
+        dmi_data.set_write_latency(sc_time(1, SC_NS));
+        return true;
     }
 
     unsigned int transport_dbg(tlm::tlm_generic_payload& trans)
     {
-        if (trans.get_address() >= 1024)
+        if (trans.get_address() >= bytes)
         {
              SC_REPORT_INFO("mem", "Out of memory range");
              return 0;
         }
 
+        unsigned int length = std::min<sc_dt::uint64>(
+                trans.get_data_length(),
+                bytes - trans.get_address());
+
         if(trans.get_command() == tlm::TLM_WRITE_COMMAND)
         {
-            memcpy(&data[trans.get_address()], // destination
+            memcpy(data + trans.get_address(), // destination
                    trans.get_data_ptr(),      // source
-                   trans.get_data_length()); // size
+                   length);                  // size
         }
         else // (trans.get_command() == tlm::TLM_READ_COMMAND)
         {
             memcpy(trans.get_data_ptr(),        // destination
-                   &data[trans.get_address()], // source
-                   trans.get_data_length());  // size
+                   data + trans.get_address(), // source
+                   length);                    // size
         }
 
-        return trans.get_data_length();
+        return length;
 
     }
 
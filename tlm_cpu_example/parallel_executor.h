@@ -0,0 +1,238 @@
+/*
+ * Copyright 2017 Matthias Jung
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PARALLEL_EXECUTOR_H
+#define PARALLEL_EXECUTOR_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <systemc.h>
+#include <tlm.h>
+
+// Core whose quantum bodies can run on a host thread outside of SystemC:
+class parallel_core
+{
+    public:
+    virtual ~parallel_core()
+    {
+    }
+
+    // Called on the SystemC thread before the first quantum:
+    virtual void boot() = 0;
+
+    // Called on a worker thread, must not call the SystemC kernel:
+    virtual void runQuantum(const sc_time &quantum) = 0;
+
+    virtual bool isHalted() const = 0;
+};
+
+// Executes the quantum bodies of independent cores on a pool of host
+// threads. At every quantum boundary the SC_THREAD of the executor hands
+// one job per running core to the pool, waits until all of them are
+// finished and then advances the SystemC time by one quantum. The cores
+// must only touch memory they have DMI pointers for. All other
+// b_transport calls are queued by the workers with transport() and
+// executed on the SystemC thread while the workers are blocked.
+SC_MODULE(parallel_executor)
+{
+    public:
+    SC_HAS_PROCESS(parallel_executor);
+    parallel_executor(sc_module_name name,
+                      sc_time quantum,
+                      unsigned int threads) :
+        sc_module(name),
+        quantum(quantum),
+        threads(threads),
+        pending(0),
+        shutdown(false)
+    {
+        SC_THREAD(run);
+    }
+
+    ~parallel_executor()
+    {
+        join();
+    }
+
+    void add(parallel_core *core)
+    {
+        cores.push_back(core);
+    }
+
+    // Called by the workers:
+    void transport(tlm::tlm_fw_transport_if<> *target,
+                   tlm::tlm_generic_payload &trans,
+                   sc_time &delay)
+    {
+        request r = {target, &trans, &delay, false};
+
+        std::unique_lock<std::mutex> lock(mutex);
+        requests.push_back(&r);
+        kernelCondition.notify_one();
+        workerCondition.wait(lock, [&r]{ return r.done; });
+    }
+
+    private:
+    struct request
+    {
+        tlm::tlm_fw_transport_if<> *target;
+        tlm::tlm_generic_payload *trans;
+        sc_time *delay;
+        bool done;
+    };
+
+    sc_time quantum;
+    unsigned int threads;
+
+    std::vector<parallel_core*> cores;
+    std::vector<std::thread> pool;
+
+    std::mutex mutex;
+    std::condition_variable kernelCondition;
+    std::condition_variable workerCondition;
+    std::vector<parallel_core*> jobs;
+    std::deque<request*> requests;
+    unsigned int pending;
+    bool shutdown;
+
+    void run()
+    {
+        for(parallel_core *c : cores)
+        {
+            c->boot();
+        }
+
+        for(unsigned int i = 0; i < threads; i++)
+        {
+            pool.emplace_back(&parallel_executor::work, this);
+        }
+
+        while(true)
+        {
+            std::vector<parallel_core*> active;
+            for(parallel_core *c : cores)
+            {
+                if(!c->isHalted())
+                {
+                    active.push_back(c);
+                }
+            }
+
+            if(active.empty())
+            {
+                break;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            jobs = active;
+            pending = active.size();
+            workerCondition.notify_all();
+
+            while(pending > 0)
+            {
+                kernelCondition.wait(lock, [this]{
+                    return pending == 0 || !requests.empty();
+                });
+
+                while(!requests.empty())
+                {
+                    request *r = requests.front();
+                    requests.pop_front();
+
+                    lock.unlock();
+                    r->target->b_transport(*r->trans, *r->delay);
+                    lock.lock();
+
+                    r->done = true;
+                    workerCondition.notify_all();
+                }
+            }
+            lock.unlock();
+
+            wait(quantum);
+        }
+
+        join();
+        sc_stop();
+    }
+
+    void work()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while(true)
+        {
+            workerCondition.wait(lock, [this]{
+                return shutdown || !jobs.empty();
+            });
+
+            if(shutdown)
+            {
+                return;
+            }
+
+            parallel_core *c = jobs.back();
+            jobs.pop_back();
+
+            lock.unlock();
+            c->runQuantum(quantum);
+            lock.lock();
+
+            if(--pending == 0)
+            {
+                kernelCondition.notify_one();
+            }
+        }
+    }
+
+    void join()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            shutdown = true;
+        }
+        workerCondition.notify_all();
+
+        for(std::thread &t : pool)
+        {
+            if(t.joinable())
+            {
+                t.join();
+            }
+        }
+        pool.clear();
+    }
+};
+
+#endif // PARALLEL_EXECUTOR_H
@@ -0,0 +1,695 @@
+/*
+ * Copyright 2017 Matthias Jung
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TRANSLATOR_H
+#define TRANSLATOR_H
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <systemc.h>
+#include <tlm.h>
+
+#include "instruction_profiler.h"
+#include "isa.h"
+
+// Dynamic binary translation of hot basic blocks. A basic block that was
+// entered more than threshold times is decoded once into an array of ops,
+// each op is a pointer to a small handler plus its pre-extracted operands.
+// While translated code runs, the guest registers live in a local array
+// and the blocks are chained directly, without returning to the cpu loop,
+// until the time budget is used up. Writes to x0 go to the sink x[32].
+//
+// Loads and stores access the memory inline through the DMI pointer of the
+// cpu, which is cached in the state of the run, and are counted by the
+// guest profiler of the cpu, if any. Accesses outside of the DMI region go
+// through the load and store of the cpu.
+//
+// Every store of the cpu reports its address with written(). Stores into
+// a 64 byte line that contains translated code flush all translations, and
+// the running block is left right after the store.
+template <class CORE>
+class translator
+{
+    public:
+    translator(CORE &core,
+               const sc_time &cycleTime,
+               unsigned int threshold = 16,
+               unsigned int maxLength = 64) :
+        core(core),
+        cycleTime(cycleTime),
+        threshold(threshold),
+        maxLength(maxLength),
+        flushPending(false)
+    {
+    }
+
+    // Executes translated code if the pc of the core is the start of a hot
+    // block. Returns the number of executed instructions.
+    uint64_t run(sc_time &delay, const sc_time &budget)
+    {
+        if(flushPending)
+        {
+            flush();
+        }
+
+        block *b = lookup(core.r.getPc());
+        if(b == nullptr)
+        {
+            return 0;
+        }
+
+        state s;
+        s.self = this;
+        s.core = &core;
+        s.profiler = core.profiler;
+        s.delay = SC_ZERO_TIME;
+        cacheDmi(s);
+        core.r.load(s.x);
+
+        uint64_t executed = 0;
+        while(true)
+        {
+            s.pc = b->end;
+
+            const op *o = b->ops.data();
+            const op *end = o + b->ops.size();
+            while(o != end && o->execute(s, *o))
+            {
+                o++;
+            }
+
+            if(o == end)
+            {
+                s.delay += b->cycles;
+                executed += b->ops.size();
+                b->executions++;
+                b->taken += s.pc != b->end;
+            }
+            else
+            {
+                // Left after a store into translated code:
+                s.pc = o->pc + 4;
+                o++;
+                for(const op *p = b->ops.data(); p != o; p++)
+                {
+                    s.delay += p->time;
+                    if(core.profiler)
+                    {
+                        core.profiler->executed(p->pc, CMD(p->cmd));
+                    }
+                }
+                executed += o - b->ops.data();
+                break;
+            }
+
+            if(flushPending || s.delay >= budget)
+            {
+                break;
+            }
+
+            b = chain(b, s.pc);
+            if(b == nullptr)
+            {
+                break;
+            }
+        }
+
+        core.r.store(s.x);
+        core.r.setPc(s.pc);
+        delay += s.delay;
+
+        return executed;
+    }
+
+    // Called for every store of the core:
+    void written(uint32_t address, unsigned int size)
+    {
+        uint32_t first = address >> lineBits;
+        uint32_t last = (address + size - 1) >> lineBits;
+
+        if((first < code.size() && code[first])
+           || (last < code.size() && code[last]))
+        {
+            flushPending = true;
+        }
+    }
+
+    void flush()
+    {
+        if(core.profiler)
+        {
+            for(auto &b : storage)
+            {
+                for(const op &o : b->ops)
+                {
+                    core.profiler->executed(o.pc, CMD(o.cmd), b->executions);
+                }
+                core.profiler->taken(b->ops.back().pc, b->taken);
+            }
+        }
+
+        blocks.clear();
+        counters.clear();
+        storage.clear();
+        code.clear();
+        flushPending = false;
+    }
+
+    private:
+    struct state;
+    struct op;
+    typedef bool (*handler)(state&, const op&);
+
+    struct state
+    {
+        int32_t x[33];
+        uint32_t pc;
+        sc_time delay;
+        translator *self;
+        CORE *core;
+        instruction_profiler *profiler;
+
+        // DMI region of the cpu, a size of 0 disables the inline access:
+        unsigned char *dmi;
+        uint64_t dmiStart;
+        uint64_t readSize;
+        uint64_t writeSize;
+        sc_time readLatency;
+        sc_time writeLatency;
+    };
+
+    struct op
+    {
+        handler execute;
+        sc_time time;       // Fetch and, without memory access, execution
+        uint32_t pc;
+        int32_t imm;
+        uint8_t rd;
+        uint8_t rs1;
+        uint8_t rs2;
+        uint8_t cmd;
+        bool memory;
+    };
+
+    struct block
+    {
+        std::vector<op> ops;
+        uint32_t end;       // Address after the last instruction
+        sc_time cycles;     // Sum of the op times
+        block *next[2];     // Chained successors, taken and fall through
+        uint32_t nextPc[2];
+        uint64_t executions; // Complete executions, for the profiler
+        uint64_t taken;
+    };
+
+    enum : uint32_t { lineBits = 6 };
+
+    CORE &core;
+    sc_time cycleTime;
+    unsigned int threshold;
+    unsigned int maxLength;
+    bool flushPending;
+
+    std::unordered_map<uint32_t, block*> blocks; // nullptr: not translatable
+    std::unordered_map<uint32_t, unsigned int> counters;
+    std::vector<std::unique_ptr<block>> storage;
+    std::vector<bool> code;                      // 64 byte lines with code
+
+    void cacheDmi(state &s)
+    {
+        s.dmi = nullptr;
+        s.dmiStart = 0;
+        s.readSize = 0;
+        s.writeSize = 0;
+
+        if(core.dmiValid)
+        {
+            const tlm::tlm_dmi &d = core.dmi;
+            uint64_t size = d.get_end_address() - d.get_start_address() + 1;
+            s.dmi = d.get_dmi_ptr();
+            s.dmiStart = d.get_start_address();
+            s.readSize = d.is_read_allowed() ? size : 0;
+            s.writeSize = d.is_write_allowed() ? size : 0;
+            s.readLatency = d.get_read_latency();
+            s.writeLatency = d.get_write_latency();
+        }
+    }
+
+    // A transport of the cpu may have invalidated the DMI pointer:
+    static void checkDmi(state &s)
+    {
+        if(!s.core->dmiValid)
+        {
+            s.readSize = 0;
+            s.writeSize = 0;
+        }
+    }
+
+    template <class T>
+    static bool load(state &s, const op &o)
+    {
+        uint32_t address = s.x[o.rs1] + o.imm;
+        uint64_t offset = uint64_t(address) - s.dmiStart;
+
+        if(offset + sizeof(T) <= s.readSize)
+        {
+            T value;
+            memcpy(&value, s.dmi + offset, sizeof(T));
+            s.x[o.rd] = value;
+            s.delay += s.readLatency;
+            if(s.profiler)
+            {
+                s.profiler->load(address);
+            }
+        }
+        else
+        {
+            s.x[o.rd] = s.core->template load<T>(address, s.delay);
+            checkDmi(s);
+        }
+        return true;
+    }
+
+    template <class T>
+    static bool store(state &s, const op &o)
+    {
+        uint32_t address = s.x[o.rs1] + o.imm;
+        uint64_t offset = uint64_t(address) - s.dmiStart;
+
+        if(offset + sizeof(T) <= s.writeSize)
+        {
+            T value = s.x[o.rs2];
+            memcpy(s.dmi + offset, &value, sizeof(T));
+            s.delay += s.writeLatency;
+            if(s.profiler)
+            {
+                s.profiler->store(address);
+            }
+            s.self->written(address, sizeof(T));
+        }
+        else
+        {
+            s.core->template store<T>(address, s.x[o.rs2], s.delay);
+            checkDmi(s);
+        }
+        return !s.self->flushPending;
+    }
+
+    block* lookup(uint32_t pc)
+    {
+        auto b = blocks.find(pc);
+        if(b != blocks.end())
+        {
+            return b->second;
+        }
+
+        if(++counters[pc] < threshold)
+        {
+            return nullptr;
+        }
+
+        block *t = translate(pc);
+        blocks[pc] = t;
+        return t;
+    }
+
+    block* chain(block *b, uint32_t pc)
+    {
+        int slot = (pc == b->end) ? 1 : 0;
+
+        if(b->next[slot] && b->nextPc[slot] == pc)
+        {
+            return b->next[slot];
+        }
+
+        block *n = lookup(pc);
+        if(n)
+        {
+            b->next[slot] = n;
+            b->nextPc[slot] = pc;
+        }
+        return n;
+    }
+
+    block* translate(uint32_t pc)
+    {
+        std::unique_ptr<block> b(new block());
+        b->next[0] = b->next[1] = nullptr;
+        b->nextPc[0] = b->nextPc[1] = 0;
+        b->executions = 0;
+        b->taken = 0;
+
+        b->cycles = SC_ZERO_TIME;
+        uint32_t address = pc;
+
+        while(b->ops.size() < maxLength)
+        {
+            // The fetch latency is taken once, at translation:
+            uint32_t data = 0;
+            sc_time fetch = core.fetch(address, data);
+            if(data == 0)
+            {
+                break;
+            }
+
+            CMD cmd = core.decode(data);
+            if(cmd == nop || cmd >= fence)
+            {
+                break;
+            }
+
+            op o = bind(cmd, data, address);
+            o.time = o.memory ? fetch : fetch + cycleTime;
+            b->ops.push_back(o);
+            b->cycles += o.time;
+            address += 4;
+
+            if(endsBlock(cmd))
+            {
+                break;
+            }
+        }
+
+        if(b->ops.empty())
+        {
+            return nullptr;
+        }
+
+        b->end = address;
+
+        for(uint32_t l = pc >> lineBits; l <= (address - 1) >> lineBits; l++)
+        {
+            if(l >= code.size())
+            {
+                code.resize(l + 1, false);
+            }
+            code[l] = true;
+        }
+
+        storage.push_back(std::move(b));
+        return storage.back().get();
+    }
+
+    static op bind(CMD cmd, uint32_t data, uint32_t pc)
+    {
+        op o;
+        o.pc = pc;
+        o.cmd = cmd;
+        o.rd = (data >> 7) & 0b11111;
+        o.rs1 = (data >> 15) & 0b11111;
+        o.rs2 = (data >> 20) & 0b11111;
+        o.imm = immI(data);
+        o.memory = false;
+
+        if(o.rd == 0)
+        {
+            o.rd = 32;
+        }
+
+        switch(cmd)
+        {
+            case lui:
+                o.imm = immU(data);
+                o.execute = [](state &s, const op &o) {
+                    s.x[o.rd] = o.imm; return true; };
+                break;
+            case auipc:
+                o.imm = pc + immU(data);
+                o.execute = [](state &s, const op &o) {
+                    s.x[o.rd] = o.imm; return true; };
+                break;
+
+            case jal:
+                o.imm = immJ(data);
+                o.execute = [](state &s, const op &o) {
+                    s.x[o.rd] = o.pc + 4;
+                    s.pc = o.pc + o.imm;
+                    return true; };
+                break;
+            case jalr:
+                o.execute = [](state &s, const op &o) {
+                    uint32_t target = (s.x[o.rs1] + o.imm) & ~1u;
+                    s.x[o.rd] = o.pc + 4;
+                    s.pc = target;
+                    return true; };
+                break;
+
+            case beq:
+                o.imm = immB(data);
+                o.execute = [](state &s, const op &o) {
+                    if(s.x[o.rs1] == s.x[o.rs2]) s.pc = o.pc + o.imm;
+                    return true; };
+                break;
+            case bne:
+                o.imm = immB(data);
+                o.execute = [](state &s, const op &o) {
+                    if(s.x[o.rs1] != s.x[o.rs2]) s.pc = o.pc + o.imm;
+                    return true; };
+                break;
+            case blt:
+                o.imm = immB(data);
+                o.execute = [](state &s, const op &o) {
+                    if(s.x[o.rs1] < s.x[o.rs2]) s.pc = o.pc + o.imm;
+                    return true; };
+                break;
+            case bge:
+                o.imm = immB(data);
+                o.execute = [](state &s, const op &o) {
+                    if(s.x[o.rs1] >= s.x[o.rs2]) s.pc = o.pc + o.imm;
+                    return true; };
+                break;
+            case bltu:
+                o.imm = immB(data);
+                o.execute = [](state &s, const op &o) {
+                    if((uint32_t)s.x[o.rs1] < (uint32_t)s.x[o.rs2])
+                        s.pc = o.pc + o.imm;
+                    return true; };
+                break;
+            case bgeu:
+                o.imm = immB(data);
+                o.execute = [](state &s, const op &o) {
+                    if((uint32_t)s.x[o.rs1] >= (uint32_t)s.x[o.rs2])
+                        s.pc = o.pc + o.imm;
+                    return true; };
+                break;
+
+            case lb:
+                o.memory = true;
+                o.execute = load<int8_t>;
+                break;
+            case lh:
+                o.memory = true;
+                o.execute = load<int16_t>;
+                break;
+            case lw:
+                o.memory = true;
+                o.execute = load<int32_t>;
+                break;
+            case lbu:
+                o.memory = true;
+                o.execute = load<uint8_t>;
+                break;
+            case lhu:
+                o.memory = true;
+                o.execute = load<uint16_t>;
+                break;
+
+            case sb:
+                o.memory = true;
+                o.imm = immS(data);
+                o.execute = store<uint8_t>;
+                break;
+            case sh:
+                o.memory = true;
+                o.imm = immS(data);
+                o.execute = store<uint16_t>;
+                break;
+            case sw:
+                o.memory = true;
+                o.imm = immS(data);
+                o.execute = store<uint32_t>;
+                break;
+
+            case addi:
+                o.execute = [](state &s, const op &o) {
+                    s.x[o.rd] = (uint32_t)s.x[o.rs1] + o.imm; return true; };
+                break;
+            case slti:
+                o.execute = [](state &s, const op &o) {
+                    s.x[o.rd] = s.x[o.rs1] < o.imm; return true; };
+                break;
+            case sltiu:
+                o.execute = [](state &s, const op &o) {
+                    s.x[o.rd] = (uint32_t)s.x[o.rs1] < (uint32_t)o.imm;
+                    return true; };
+                break;
+            case xori:
+                o.execute = [](state &s, const op &o) {
+                    s.x[o.rd] = s.x[o.rs1] ^ o.imm; return true; };
+                break;
+            case ori:
+                o.execute = [](state &s, const op &o) {
+                    s.x[o.rd] = s.x[o.rs1] | o.imm; return true; };
+                break;
+            case andi:
+                o.execute = [](state &s, const op &o) {
+                    s.x[o.rd] = s.x[o.rs1] & o.imm; return true; };
+                break;
+            case slli:
+                o.imm = o.rs2;
+                o.execute = [](state &s, const op &o) {
+                    s.x[o.rd] = (uint32_t)s.x[o.rs1] << o.imm; return true; };
+                break;
+            case srli:
+                o.imm = o.rs2;
+                o.execute = [](state &s, const op &o) {
+                    s.x[o.rd] = (uint32_t)s.x[o.rs1] >> o.imm; return true; };
+                break;
+            case srai:
+                o.imm = o.rs2;
+                o.execute = [](state &s, const op &o) {
+                    s.x[o.rd] = s.x[o.rs1] >> o.imm; return true; };
+                break;
+
+            case add:
+                o.execute = [](state &s, const op &o) {
+                    s.x[o.rd] = (uint32_t)s.x[o.rs1] + (uint32_t)s.x[o.rs2];
+                    return true; };
+                break;
+            case sub:
+                o.execute = [](state &s, const op &o) {
+                    s.x[o.rd] = (uint32_t)s.x[o.rs1] - (uint32_t)s.x[o.rs2];
+                    return true; };
+                break;
+            case sll:
+                o.execute = [](state &s, const op &o) {
+                    s.x[o.rd] = (uint32_t)s.x[o.rs1] << (s.x[o.rs2] & 31);
+                    return true; };
+                break;
+            case slt:
+                o.execute = [](state &s, const op &o) {
+                    s.x[o.rd] = s.x[o.rs1] < s.x[o.rs2]; return true; };
+                break;
+            case sltu:
+                o.execute = [](state &s, const op &o) {
+                    s.x[o.rd] = (uint32_t)s.x[o.rs1] < (uint32_t)s.x[o.rs2];
+                    return true; };
+                break;
+            case xor_:
+                o.execute = [](state &s, const op &o) {
+                    s.x[o.rd] = s.x[o.rs1] ^ s.x[o.rs2]; return true; };
+                break;
+            case srl:
+                o.execute = [](state &s, const op &o) {
+                    s.x[o.rd] = (uint32_t)s.x[o.rs1] >> (s.x[o.rs2] & 31);
+                    return true; };
+                break;
+            case sra:
+                o.execute = [](state &s, const op &o) {
+                    s.x[o.rd] = s.x[o.rs1] >> (s.x[o.rs2] & 31); return true; };
+                break;
+            case or_:
+                o.execute = [](state &s, const op &o) {
+                    s.x[o.rd] = s.x[o.rs1] | s.x[o.rs2]; return true; };
+                break;
+            case and_:
+                o.execute = [](state &s, const op &o) {
+                    s.x[o.rd] = s.x[o.rs1] & s.x[o.rs2]; return true; };
+                break;
+
+            case mul:
+                o.execute = [](state &s, const op &o) {
+                    s.x[o.rd] = (uint32_t)s.x[o.rs1] * (uint32_t)s.x[o.rs2];
+                    return true; };
+                break;
+            case mulh:
+                o.execute = [](state &s, const op &o) {
+                    s.x[o.rd] = ((int64_t)s.x[o.rs1]
+                              * (int64_t)s.x[o.rs2]) >> 32;
+                    return true; };
+                break;
+            case mulhsu:
+                o.execute = [](state &s, const op &o) {
+                    s.x[o.rd] = ((int64_t)s.x[o.rs1]
+                              * (int64_t)(uint32_t)s.x[o.rs2]) >> 32;
+                    return true; };
+                break;
+            case mulhu:
+                o.execute = [](state &s, const op &o) {
+                    s.x[o.rd] = ((uint64_t)(uint32_t)s.x[o.rs1]
+                              * (uint64_t)(uint32_t)s.x[o.rs2]) >> 32;
+                    return true; };
+                break;
+            case div_:
+                o.execute = [](state &s, const op &o) {
+                    int32_t a = s.x[o.rs1];
+                    int32_t b = s.x[o.rs2];
+                    s.x[o.rd] = b == 0 ? -1
+                              : (a == INT32_MIN && b == -1) ? a : a / b;
+                    return true; };
+                break;
+            case divu:
+                o.execute = [](state &s, const op &o) {
+                    uint32_t a = s.x[o.rs1];
+                    uint32_t b = s.x[o.rs2];
+                    s.x[o.rd] = b == 0 ? 0xffffffff : a / b;
+                    return true; };
+                break;
+            case rem:
+                o.execute = [](state &s, const op &o) {
+                    int32_t a = s.x[o.rs1];
+                    int32_t b = s.x[o.rs2];
+                    s.x[o.rd] = b == 0 ? a
+                              : (a == INT32_MIN && b == -1) ? 0 : a % b;
+                    return true; };
+                break;
+            case remu:
+                o.execute = [](state &s, const op &o) {
+                    uint32_t a = s.x[o.rs1];
+                    uint32_t b = s.x[o.rs2];
+                    s.x[o.rd] = b == 0 ? a : a % b;
+                    return true; };
+                break;
+
+            default:
+                // nop and the system instructions are never translated
+                o.execute = nullptr;
+                break;
+        }
+
+        return o;
+    }
+};
+
+#endif // TRANSLATOR_H